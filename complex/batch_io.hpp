@@ -0,0 +1,173 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "mapped_file.hpp"
+
+namespace complex_eval {
+
+// 批处理模式的输出缓冲：攒满一大块再一次性写出，代替逐行刷新的 std::cout。
+class BufferedOutput : public std::streambuf {
+public:
+    explicit BufferedOutput(std::FILE* file, std::size_t capacity = 1 << 20)
+        : target(file), buffer(capacity) {
+        setp(buffer.data(), buffer.data() + buffer.size());
+    }
+
+    BufferedOutput(const BufferedOutput&) = delete;
+    BufferedOutput& operator=(const BufferedOutput&) = delete;
+
+    ~BufferedOutput() override { sync(); }
+
+protected:
+    int_type overflow(int_type ch) override {
+        if (sync() != 0) return traits_type::eof();
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    int sync() override {
+        const std::size_t n = static_cast<std::size_t>(pptr() - pbase());
+        if (n > 0 && std::fwrite(pbase(), 1, n, target) != n) return -1;
+        setp(buffer.data(), buffer.data() + buffer.size());
+        return std::fflush(target) == 0 ? 0 : -1;
+    }
+
+private:
+    std::FILE* target;
+    std::vector<char> buffer;
+};
+
+// 逐行回调 fn(line, lineNo)，line 是指向 data 的 string_view，行号从 1 开始；fn 返回 false 时停止。
+// 行尾的 '\r' 保留给会话处理（trim 与 scan 都会忽略）。
+template <class Fn>
+bool forEachLineInBuffer(const char* data, std::size_t size, std::size_t& lineNo, Fn& fn) {
+    const char* cur = data;
+    const char* end = data + size;
+    while (cur < end) {
+        const char* nl = static_cast<const char*>(std::memchr(cur, '\n', static_cast<std::size_t>(end - cur)));
+        const char* stop = nl ? nl : end;
+        if (!fn(std::string_view(cur, static_cast<std::size_t>(stop - cur)), ++lineNo)) return false;
+        cur = nl ? nl + 1 : end;
+    }
+    return true;
+}
+
+// 以大块 fread 读取流（如管道中的 stdin），跨块的半行留到下一块拼接。
+// 一行累计超过 longLine 字节仍没有换行时不再拼接，改为调用 longFn(source, lineNo)：
+// source() 依次返回该行的各段（已读到的部分以及后续各块中的部分），返回空视图表示行结束，
+// 每段在下一次调用前有效。这样超长行只占用一个块的内存；longFn 没读完的部分会被跳过。
+template <class Fn, class LongFn>
+void forEachLineInStream(std::FILE* in, Fn&& fn, LongFn&& longFn, std::size_t longLine,
+                         std::size_t blockSize = 1 << 20) {
+    std::vector<char> block(blockSize);
+    const char* data = block.data();
+    std::size_t size = 0;  // block 中尚未处理的字节
+    std::string carry;
+    std::size_t lineNo = 0;
+
+    auto refill = [&] {
+        size = std::fread(block.data(), 1, block.size(), in);
+        data = block.data();
+        if (size == 0 && std::ferror(in)) {
+            throw std::runtime_error("Failed to read input");
+        }
+        return size > 0;
+    };
+
+    for (;;) {
+        if (size == 0 && !refill()) break;
+
+        const char* nl = static_cast<const char*>(std::memchr(data, '\n', size));
+        if (nl) {
+            const std::size_t len = static_cast<std::size_t>(nl - data);
+            bool more;
+            if (carry.empty()) {
+                more = fn(std::string_view(data, len), ++lineNo);
+            } else {
+                carry.append(data, len);
+                more = fn(std::string_view(carry), ++lineNo);
+                carry.clear();
+            }
+            size -= len + 1;
+            data = nl + 1;
+            if (!more) return;
+            continue;
+        }
+
+        if (carry.size() + size <= longLine) {
+            carry.append(data, size);
+            size = 0;
+            continue;
+        }
+
+        bool sentCarry = carry.empty();
+        bool ended = false;
+        auto source = [&]() -> std::string_view {
+            if (ended) return {};
+            if (!sentCarry) {
+                sentCarry = true;
+                return carry;
+            }
+            if (size == 0 && !refill()) {
+                ended = true;
+                return {};
+            }
+            const char* lineEnd = static_cast<const char*>(std::memchr(data, '\n', size));
+            const std::size_t len = lineEnd ? static_cast<std::size_t>(lineEnd - data) : size;
+            const std::string_view part(data, len);
+            size -= lineEnd ? len + 1 : len;
+            data += lineEnd ? len + 1 : len;
+            ended = (lineEnd != nullptr);
+            return part;
+        };
+        const bool more = longFn(source, ++lineNo);
+        while (!source().empty()) {
+        }
+        carry.clear();
+        if (!more) return;
+    }
+    if (!carry.empty()) {
+        fn(std::string_view(carry), ++lineNo);
+    }
+}
+
+// 不区分超长行，每行都拼接完整后交给 fn。
+template <class Fn>
+void forEachLineInStream(std::FILE* in, Fn&& fn, std::size_t blockSize = 1 << 20) {
+    forEachLineInStream(
+        in, fn, [](auto&&, std::size_t) { return true; }, static_cast<std::size_t>(-1), blockSize);
+}
+
+// 普通文件通过 mmap 映射后按行切分，不经过 iostream，行内容也不拷贝。
+// 管道、FIFO（如 -f /dev/stdin、-f <(gen)）无法映射，改为按块读取，超长行交给 longFn。
+template <class Fn, class LongFn>
+void forEachLineInFile(const std::string& path, Fn&& fn, LongFn&& longFn, std::size_t longLine) {
+#ifdef COMPLEX_EVAL_HAS_MMAP
+    struct stat st {};
+    if (::stat(path.c_str(), &st) == 0 && !S_ISREG(st.st_mode)) {
+        std::unique_ptr<std::FILE, int (*)(std::FILE*)> in(std::fopen(path.c_str(), "rb"), &std::fclose);
+        if (!in) {
+            throw std::runtime_error("Cannot open file: " + path);
+        }
+        forEachLineInStream(in.get(), fn, longFn, longLine);
+        return;
+    }
+#endif
+    MappedFile file(path);
+    std::size_t lineNo = 0;
+    forEachLineInBuffer(file.data(), file.size(), lineNo, fn);
+}
+
+}  // namespace complex_eval
@@ -1,12 +1,18 @@
 #pragma once
 
+#include <cstdint>
+#include <limits>
 #include <stack>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "big_complex.hpp"
+#include "reduction.hpp"
+#include "scanner.hpp"
 #include "token.hpp"
+#include "transcendental.hpp"
 
 namespace complex_eval {
 
@@ -18,6 +24,22 @@ inline Big parseBig(const std::string& text) {
     }
 }
 
+// what 用于错误信息，如 "pow exponent"。
+inline long long integerArgument(const Complex& value, const std::string& what,
+                                 long long limit = std::numeric_limits<long long>::max()) {
+    using boost::multiprecision::abs;
+    using boost::multiprecision::floor;
+
+    const Big& re = value.realPart();
+    if (value.imagPart() != 0 || floor(re) != re) {
+        throw std::runtime_error(what + " must be an integer");
+    }
+    if (abs(re) > Big(limit)) {
+        throw std::runtime_error(what + " out of range");
+    }
+    return re.convert_to<long long>();
+}
+
 inline Complex popOperator(std::stack<Complex>& values,
                            std::stack<Op>& ops,
                            std::stack<std::string>& assignTargets,
@@ -70,55 +92,292 @@ inline Complex popOperator(std::stack<Complex>& values,
             Complex arg = values.top(); values.pop();
             return Complex(arg.magnitude(), Big(0));
         }
+        case Op::FnExp: {
+            Complex arg = values.top(); values.pop();
+            return expComplex(arg);
+        }
+        case Op::FnLog: {
+            Complex arg = values.top(); values.pop();
+            return logComplex(arg);
+        }
+        case Op::FnSqrt: {
+            Complex arg = values.top(); values.pop();
+            return sqrtComplex(arg);
+        }
+        case Op::FnArg: {
+            Complex arg = values.top(); values.pop();
+            return argComplex(arg);
+        }
+        case Op::FnPow: {
+            Complex exponent = values.top(); values.pop();
+            Complex base = values.top(); values.pop();
+            return powComplex(base, integerArgument(exponent, "pow exponent"));
+        }
         default:
             throw std::runtime_error("Invalid operator");
     }
 }
 
-inline bool evaluate(const std::vector<Token>& tokens,
-                     std::unordered_map<std::string, Complex>& variables,
-                     Complex& result) {
+inline Complex parseNumberLex(const std::string& lex) {
+    if (lex == "i") {
+        return Complex(Big(0), Big(1));
+    }
+    if (!lex.empty() && lex.back() == 'i') {
+        std::string imagPart = lex.substr(0, lex.size() - 1);
+        if (imagPart.empty() || imagPart == "+" || imagPart == "-") {
+            return Complex(Big(0), (imagPart == "-") ? Big(-1) : Big(1));
+        }
+        return Complex(Big(0), parseBig(imagPart));
+    }
+    return Complex(parseBig(lex), Big(0));
+}
+
+// 预编译的表达式：tokens 加上按出现顺序预先解析好的数字字面量，
+// 重复求值时无需再次词法分析和十进制解析。
+// literalSlot[i] 是第 i 个 token 在 literals 中的下标（仅对 Number 有意义）。
+struct CompiledExpr {
+    std::vector<Token> tokens;
+    std::vector<Complex> literals;
+    std::vector<std::uint32_t> literalSlot;
+};
+
+inline void indexLiterals(CompiledExpr& expr) {
+    expr.literalSlot.assign(expr.tokens.size(), 0);
+    std::uint32_t next = 0;
+    for (std::size_t i = 0; i < expr.tokens.size(); ++i) {
+        if (expr.tokens[i].kind == Kind::Number) {
+            expr.literalSlot[i] = next++;
+        }
+    }
+    if (next != expr.literals.size()) {
+        throw std::runtime_error("Internal error: literal count mismatch");
+    }
+}
+
+inline CompiledExpr compile(std::vector<Token> tokens) {
+    CompiledExpr expr;
+    for (const Token& tk : tokens) {
+        if (tk.kind == Kind::Number) {
+            expr.literals.push_back(parseNumberLex(tk.lex));
+        }
+    }
+    expr.tokens = std::move(tokens);
+    indexLiterals(expr);
+    return expr;
+}
+
+namespace detail {
+
+// sum/prod 的下标变量绑定，内层在前，查找时先于全局变量。
+struct Binding {
+    const std::string& name;
+    const Complex& value;
+    const Binding* outer;
+};
+
+inline const Complex* findBinding(const Binding* b, const std::string& name) {
+    for (; b != nullptr; b = b->outer) {
+        if (b->name == name) return &b->value;
+    }
+    return nullptr;
+}
+
+// sum/prod 的上下界限制，保证项数与下标运算不会溢出 long long。
+constexpr long long kMaxReductionBound = 1000000000000000LL;
+
+template <class NumberAt>
+bool evaluateTokens(const std::vector<Token>& tokens, std::size_t first, std::size_t last,
+                    const NumberAt& numberAt,
+                    std::unordered_map<std::string, Complex>& variables,
+                    const Binding* bindings,
+                    unsigned threads,
+                    Complex& result);
+
+// 展开 tokens[at] 处的 sum(k, a, b, body) / prod(k, a, b, body)，close 返回匹配的 ')' 下标。
+// 循环体最多用 threads 个线程并行求值，只读共享的变量表，因此整个调用内不允许赋值。
+template <class NumberAt>
+Complex evaluateReduction(const std::vector<Token>& tokens, std::size_t at, std::size_t last,
+                          const NumberAt& numberAt,
+                          std::unordered_map<std::string, Complex>& variables,
+                          const Binding* bindings,
+                          unsigned threads,
+                          std::size_t& close) {
+    const Op op = tokens[at].op;
+    const std::size_t open = at + 1;
+    if (open >= last || tokens[open].kind != Kind::OpTok || tokens[open].op != Op::LParen) {
+        throw std::runtime_error("Missing '(' after function name");
+    }
+
+    std::vector<std::size_t> commas;
+    int depth = 0;
+    std::size_t k = open;
+    for (; k < last; ++k) {
+        if (tokens[k].kind != Kind::OpTok) continue;
+        const Op inner = tokens[k].op;
+        if (inner == Op::LParen) {
+            ++depth;
+        } else if (inner == Op::RParen) {
+            if (--depth == 0) break;
+        } else if (inner == Op::Comma && depth == 1) {
+            commas.push_back(k);
+        } else if (inner == Op::Assign) {
+            throw std::runtime_error("Assignment is not allowed inside sum/prod");
+        }
+    }
+    if (k >= last) {
+        throw std::runtime_error("Mismatched parentheses");
+    }
+    if (commas.size() != static_cast<std::size_t>(arity(op) - 1)) {
+        throw std::runtime_error("Wrong number of arguments");
+    }
+    close = k;
+
+    if (commas[0] != open + 2 || tokens[open + 1].kind != Kind::Ident) {
+        throw std::runtime_error("sum/prod index must be a variable name");
+    }
+    const std::string& index = tokens[open + 1].lex;
+
+    auto bound = [&](std::size_t from, std::size_t to) {
+        Complex value;
+        evaluateTokens(tokens, from, to, numberAt, variables, bindings, threads, value);
+        return integerArgument(value, "sum/prod bound", kMaxReductionBound);
+    };
+    const long long lo = bound(commas[0] + 1, commas[1]);
+    const long long hi = bound(commas[1] + 1, commas[2]);
+    const std::size_t bodyFirst = commas[2] + 1;
+    const std::size_t bodyLast = close;
+
+    const bool isSum = (op == Op::FnSum);
+    const Complex identity = isSum ? Complex(Big(0), Big(0)) : Complex(Big(1), Big(0));
+    return parallelReduce(
+        lo, hi, threads, identity,
+        [&](long long n) {
+            const Complex value(Big(n), Big(0));
+            const Binding binding{index, value, bindings};
+            Complex term;
+            evaluateTokens(tokens, bodyFirst, bodyLast, numberAt, variables, &binding, threads, term);
+            return term;
+        },
+        [isSum](const Complex& a, const Complex& b) { return isSum ? a + b : a * b; });
+}
+
+// 加减链的成对求和：按二进制计数器合并相邻的同阶部分和，只保留 O(log n) 个部分和。
+// 合并总是“左 + 右”，项的先后次序不变；三项以内与从左到右逐项相加完全相同。
+class PairwiseSum {
+public:
+    bool empty() const { return parts.empty(); }
+
+    void add(Complex term) {
+        parts.push_back(Part{std::move(term), 0});
+        while (parts.size() >= 2 && parts[parts.size() - 2].order == parts.back().order) {
+            const Complex right = std::move(parts.back().value);
+            parts.pop_back();
+            parts.back().value = parts.back().value + right;
+            ++parts.back().order;
+        }
+    }
+
+    // 从右向左折叠剩余的部分和，并清空。
+    Complex take() {
+        Complex acc = std::move(parts.back().value);
+        parts.pop_back();
+        while (!parts.empty()) {
+            acc = parts.back().value + acc;
+            parts.pop_back();
+        }
+        return acc;
+    }
+
+private:
+    struct Part {
+        Complex value;
+        unsigned order;
+    };
+    std::vector<Part> parts;
+};
+
+inline Complex negated(const Complex& z) {
+    return Complex(-z.realPart(), -z.imagPart());
+}
+
+// 求值器的一层：根、一对括号或一次赋值的右侧。
+// 加减号不进运算符栈，本层已结束的项直接并入 chain，下一项的符号记在 pendingSub。
+struct Level {
+    enum Kind { Root, Paren, Assign };
+
+    Level(Kind k, std::size_t base) : kind(k), opsBase(base) {}
+
+    Kind kind;
+    std::size_t opsBase;  // 本层运算符在 ops 中的起点
+    int commas = 0;       // Paren 层内已出现的逗号个数
+    bool pendingSub = false;
+    PairwiseSum chain;
+};
+
+// 逐个读取 token 求值，输入由 Cursor 提供：
+//   next() 前进到下一个 token，token() 取当前 token，peek() 偷看下一个（没有时为 nullptr），
+//   number() 取当前 Number 的值，reduction() 展开当前的 sum/prod 调用并消耗到其 ')'。
+template <class Cursor>
+bool evaluateCursor(Cursor& in,
+                    std::unordered_map<std::string, Complex>& variables,
+                    const Binding* bindings,
+                    unsigned threads,
+                    Complex& result) {
     std::stack<Complex> values;
     std::stack<Op> ops;
     std::stack<std::string> assignTargets;
+    std::vector<Level> levels;
+    levels.emplace_back(Level::Root, 0);
 
     bool expectOperand = true;
     bool hadAssignment = false;
 
-    auto pushNumberFromLex = [&](const std::string& lex) {
-        if (lex == "i") {
-            values.push(Complex(Big(0), Big(1)));
-            return;
+    auto reduceTo = [&](std::size_t base) {
+        while (ops.size() > base) {
+            Complex value = popOperator(values, ops, assignTargets, variables);
+            values.push(value);
         }
-        if (!lex.empty() && lex.back() == 'i') {
-            std::string imagPart = lex.substr(0, lex.size() - 1);
-            if (imagPart.empty() || imagPart == "+" || imagPart == "-") {
-                values.push(Complex(Big(0), (imagPart == "-") ? Big(-1) : Big(1)));
-            } else {
-                values.push(Complex(Big(0), parseBig(imagPart)));
-            }
-            return;
+    };
+    // 结束本层当前的加减链，链的值留在 values 顶。
+    auto closeChain = [&](Level& level) {
+        reduceTo(level.opsBase);
+        if (!level.chain.empty()) {
+            Complex last = values.top(); values.pop();
+            level.chain.add(level.pendingSub ? negated(last) : std::move(last));
+            values.push(level.chain.take());
+        }
+        level.pendingSub = false;
+    };
+    // 遇到 ')'、','、输入结束时，先完成所有未闭合的赋值。
+    auto closeAssignLevels = [&] {
+        while (levels.back().kind == Level::Assign) {
+            closeChain(levels.back());
+            levels.pop_back();
+            Complex value = popOperator(values, ops, assignTargets, variables);
+            values.push(value);
         }
-        values.push(Complex(parseBig(lex), Big(0)));
     };
 
-    for (std::size_t i = 0; i < tokens.size(); ++i) {
-        const Token& tk = tokens[i];
+    while (in.next()) {
+        const Token& tk = in.token();
 
         if (tk.kind == Kind::Number) {
-            pushNumberFromLex(tk.lex);
+            values.push(in.number());
             expectOperand = false;
             continue;
         }
 
         if (tk.kind == Kind::Ident) {
-            bool nextIsAssign = (i + 1 < tokens.size() &&
-                                 tokens[i + 1].kind == Kind::OpTok &&
-                                 tokens[i + 1].op == Op::Assign);
+            const Token* ahead = in.peek();
+            bool nextIsAssign = (ahead != nullptr &&
+                                 ahead->kind == Kind::OpTok &&
+                                 ahead->op == Op::Assign);
             if (nextIsAssign) {
                 assignTargets.push(tk.lex);
                 values.push(Complex(Big(0), Big(0), true));
                 hadAssignment = true;
+            } else if (const Complex* bound = findBinding(bindings, tk.lex)) {
+                values.push(*bound);
             } else {
                 auto it = variables.find(tk.lex);
                 if (it == variables.end()) {
@@ -133,10 +392,25 @@ inline bool evaluate(const std::vector<Token>& tokens,
         if (tk.kind == Kind::OpTok) {
             Op op = tk.op;
 
-            if (op == Op::FnCon || op == Op::FnMod) {
+            if (isReduction(op)) {
+                if (!expectOperand) {
+                    throw std::runtime_error("Missing operator before function call");
+                }
+                values.push(in.reduction(variables, bindings, threads));
+                expectOperand = false;
+                continue;
+            }
+
+            if (isFunction(op)) {
                 if (!expectOperand) {
                     throw std::runtime_error("Missing operator before function call");
                 }
+                const Token* ahead = in.peek();
+                if (arity(op) > 1 && (ahead == nullptr ||
+                                      ahead->kind != Kind::OpTok ||
+                                      ahead->op != Op::LParen)) {
+                    throw std::runtime_error("Missing '(' after function name");
+                }
                 ops.push(op);
                 expectOperand = true;
                 continue;
@@ -147,6 +421,7 @@ inline bool evaluate(const std::vector<Token>& tokens,
                     throw std::runtime_error("Missing operator before '('");
                 }
                 ops.push(op);
+                levels.emplace_back(Level::Paren, ops.size());
                 expectOperand = true;
                 continue;
             }
@@ -155,15 +430,19 @@ inline bool evaluate(const std::vector<Token>& tokens,
                 if (expectOperand) {
                     throw std::runtime_error("Missing operand before ')'");
                 }
-                while (!ops.empty() && ops.top() != Op::LParen) {
-                    Complex value = popOperator(values, ops, assignTargets, variables);
-                    values.push(value);
-                }
-                if (ops.empty() || ops.top() != Op::LParen) {
+                closeAssignLevels();
+                if (levels.back().kind != Level::Paren) {
                     throw std::runtime_error("Mismatched parentheses");
                 }
+                closeChain(levels.back());
+                const int commas = levels.back().commas;
+                levels.pop_back();
                 ops.pop();
-                if (!ops.empty() && (ops.top() == Op::FnCon || ops.top() == Op::FnMod)) {
+                const bool isCall = !ops.empty() && isFunction(ops.top());
+                if (commas != (isCall ? arity(ops.top()) - 1 : 0)) {
+                    throw std::runtime_error("Wrong number of arguments");
+                }
+                if (isCall) {
                     Complex value = popOperator(values, ops, assignTargets, variables);
                     values.push(value);
                 }
@@ -171,6 +450,20 @@ inline bool evaluate(const std::vector<Token>& tokens,
                 continue;
             }
 
+            if (op == Op::Comma) {
+                if (expectOperand) {
+                    throw std::runtime_error("Missing operand before ','");
+                }
+                closeAssignLevels();
+                if (levels.back().kind != Level::Paren) {
+                    throw std::runtime_error("Unexpected ','");
+                }
+                closeChain(levels.back());
+                ++levels.back().commas;
+                expectOperand = true;
+                continue;
+            }
+
             if (op == Op::Add || op == Op::Sub || op == Op::Mul || op == Op::Div || op == Op::Assign) {
                 if (expectOperand) {
                     if (op == Op::Add) {
@@ -182,11 +475,23 @@ inline bool evaluate(const std::vector<Token>& tokens,
                         throw std::runtime_error("Missing operand before operator");
                     }
                 }
-                while (!ops.empty() && shouldPop(ops.top(), op)) {
-                    Complex value = popOperator(values, ops, assignTargets, variables);
-                    values.push(value);
+                Level& level = levels.back();
+                if (op == Op::Add || op == Op::Sub) {
+                    reduceTo(level.opsBase);
+                    Complex term = values.top(); values.pop();
+                    level.chain.add(level.pendingSub ? negated(term) : std::move(term));
+                    level.pendingSub = (op == Op::Sub);
+                } else if (op == Op::Assign) {
+                    closeChain(level);
+                    ops.push(op);
+                    levels.emplace_back(Level::Assign, ops.size());
+                } else {
+                    while (ops.size() > level.opsBase && shouldPop(ops.top(), op)) {
+                        Complex value = popOperator(values, ops, assignTargets, variables);
+                        values.push(value);
+                    }
+                    ops.push(op);
                 }
-                ops.push(op);
                 expectOperand = true;
                 continue;
             }
@@ -201,10 +506,11 @@ inline bool evaluate(const std::vector<Token>& tokens,
         throw std::runtime_error("Expression ends with an operator");
     }
 
-    while (!ops.empty()) {
-        Complex value = popOperator(values, ops, assignTargets, variables);
-        values.push(value);
+    closeAssignLevels();
+    if (levels.size() != 1) {
+        throw std::runtime_error("Mismatched parentheses");
     }
+    closeChain(levels.back());
 
     if (values.size() != 1) {
         throw std::runtime_error("Invalid expression");
@@ -214,4 +520,144 @@ inline bool evaluate(const std::vector<Token>& tokens,
     return !hadAssignment;
 }
 
+// 在 token 数组的 [first, last) 上移动的游标。
+template <class NumberAt>
+class RangeCursor {
+public:
+    RangeCursor(const std::vector<Token>& tokens, std::size_t first, std::size_t last,
+                const NumberAt& numberAt)
+        : tokens(tokens), i(first), last(last), numberAt(numberAt) {}
+
+    bool next() {
+        if (i >= last) return false;
+        at = i++;
+        return true;
+    }
+
+    const Token& token() const { return tokens[at]; }
+    const Token* peek() const { return i < last ? &tokens[i] : nullptr; }
+    Complex number() const { return numberAt(at); }
+
+    Complex reduction(std::unordered_map<std::string, Complex>& variables, const Binding* bindings,
+                      unsigned threads) {
+        std::size_t close = at;
+        Complex value = evaluateReduction(tokens, at, last, numberAt, variables, bindings, threads, close);
+        i = close + 1;
+        return value;
+    }
+
+private:
+    const std::vector<Token>& tokens;
+    std::size_t i;
+    std::size_t at = 0;
+    std::size_t last;
+    const NumberAt& numberAt;
+};
+
+// 在 TokenStream 上移动的游标，只缓存一个向前看的 token。
+// sum/prod 的循环体要反复求值，因此只把这一次调用的 token 收集下来单独编译。
+class StreamCursor {
+public:
+    explicit StreamCursor(TokenStream& stream) : stream(stream) {}
+
+    bool next() {
+        if (peeked) {
+            peeked = false;
+            if (!hasAhead) return false;
+            current = std::move(ahead);
+            return true;
+        }
+        return stream.next(current);
+    }
+
+    const Token& token() const { return current; }
+
+    const Token* peek() {
+        if (!peeked) {
+            hasAhead = stream.next(ahead);
+            peeked = true;
+        }
+        return hasAhead ? &ahead : nullptr;
+    }
+
+    Complex number() const { return parseNumberLex(current.lex); }
+
+    Complex reduction(std::unordered_map<std::string, Complex>& variables, const Binding* bindings,
+                      unsigned threads) {
+        std::vector<Token> call{current};
+        const Token* open = peek();
+        if (open != nullptr && open->kind == Kind::OpTok && open->op == Op::LParen) {
+            int depth = 0;
+            while (next()) {
+                call.push_back(current);
+                if (current.kind != Kind::OpTok) continue;
+                if (current.op == Op::LParen) {
+                    ++depth;
+                } else if (current.op == Op::RParen && --depth == 0) {
+                    break;
+                }
+            }
+        }
+        const CompiledExpr expr = compile(std::move(call));
+        std::size_t close = 0;
+        return evaluateReduction(
+            expr.tokens, 0, expr.tokens.size(),
+            [&](std::size_t i) -> const Complex& { return expr.literals[expr.literalSlot[i]]; },
+            variables, bindings, threads, close);
+    }
+
+private:
+    TokenStream& stream;
+    Token current;
+    Token ahead;
+    bool peeked = false;
+    bool hasAhead = false;
+};
+
+// 求值 tokens[first, last)。numberAt(i) 返回第 i 个 token（Number）的值，
+// 由调用方决定现场解析还是取预解析结果。
+template <class NumberAt>
+bool evaluateTokens(const std::vector<Token>& tokens, std::size_t first, std::size_t last,
+                    const NumberAt& numberAt,
+                    std::unordered_map<std::string, Complex>& variables,
+                    const Binding* bindings,
+                    unsigned threads,
+                    Complex& result) {
+    RangeCursor<NumberAt> cursor(tokens, first, last, numberAt);
+    return evaluateCursor(cursor, variables, bindings, threads, result);
+}
+
+}  // namespace detail
+
+// threads 为 sum/prod 可用的线程数，0 表示取 hardware_concurrency。
+inline bool evaluate(const std::vector<Token>& tokens,
+                     std::unordered_map<std::string, Complex>& variables,
+                     Complex& result,
+                     unsigned threads = 0) {
+    return detail::evaluateTokens(
+        tokens, 0, tokens.size(),
+        [&](std::size_t i) { return parseNumberLex(tokens[i].lex); },
+        variables, nullptr, threads, result);
+}
+
+inline bool evaluate(const CompiledExpr& expr,
+                     std::unordered_map<std::string, Complex>& variables,
+                     Complex& result,
+                     unsigned threads = 0) {
+    return detail::evaluateTokens(
+        expr.tokens, 0, expr.tokens.size(),
+        [&](std::size_t i) -> const Complex& { return expr.literals[expr.literalSlot[i]]; },
+        variables, nullptr, threads, result);
+}
+
+// 流式求值：边读 token 边计算，内存只与括号嵌套深度和加减链的对数长度有关。
+// 词法错误在读到时才抛出，此前已完成的赋值会保留。
+inline bool evaluate(TokenStream& stream,
+                     std::unordered_map<std::string, Complex>& variables,
+                     Complex& result,
+                     unsigned threads = 0) {
+    detail::StreamCursor cursor(stream);
+    return detail::evaluateCursor(cursor, variables, nullptr, threads, result);
+}
+
 }  // namespace complex_eval
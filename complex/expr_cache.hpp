@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cctype>
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "calculator.hpp"
+#include "scanner.hpp"
+
+namespace complex_eval {
+
+// 以规范化表达式文本为键的 LRU 缓存，保存预编译结果（tokens + 预解析字面量）。
+// 命中时跳过 scan 和 parseBig；容量为 0 表示禁用缓存。
+// 所有成员函数都加锁，可由多个会话线程共享；编译在锁外进行。
+class ExprCache {
+public:
+    using Entry = std::shared_ptr<const CompiledExpr>;
+
+    explicit ExprCache(std::size_t capacity = 256) : cap(capacity) {}
+
+    // scan 会忽略所有空白，因此去掉空白后的文本就是等价表达式的规范形式。
+    static std::string normalize(const std::string& line) {
+        std::string key;
+        key.reserve(line.size());
+        for (char c : line) {
+            if (!std::isspace(static_cast<unsigned char>(c))) key.push_back(c);
+        }
+        return key;
+    }
+
+    Entry get(const std::string& line) {
+        std::string key = normalize(line);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = index.find(key);
+            if (it != index.end()) {
+                ++hitCount;
+                order.splice(order.begin(), order, it->second);
+                return it->second->second;
+            }
+            ++missCount;
+        }
+        auto entry = std::make_shared<const CompiledExpr>(compile(scan(line)));
+        insert(std::move(key), entry);
+        return entry;
+    }
+
+    // 直接放入一条编译结果（作为最近使用），用于从快照恢复。
+    void insert(std::string key, Entry entry) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (cap == 0) return;
+        auto it = index.find(key);
+        if (it != index.end()) {
+            it->second->second = std::move(entry);
+            order.splice(order.begin(), order, it->second);
+            return;
+        }
+        order.emplace_front(std::move(key), std::move(entry));
+        index.emplace(order.front().first, order.begin());
+        evict();
+    }
+
+    void setCapacity(std::size_t capacity) {
+        std::lock_guard<std::mutex> lock(mutex);
+        cap = capacity;
+        evict();
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex);
+        order.clear();
+        index.clear();
+        hitCount = 0;
+        missCount = 0;
+    }
+
+    // 按最久未使用 -> 最近使用的顺序遍历，依次 insert 即可复原相同的淘汰顺序。
+    template <class Fn>
+    void forEachOldestFirst(Fn&& fn) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto it = order.rbegin(); it != order.rend(); ++it) {
+            fn(it->first, *it->second);
+        }
+    }
+
+    std::size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return order.size();
+    }
+    std::size_t capacity() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return cap;
+    }
+    std::size_t hits() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return hitCount;
+    }
+    std::size_t misses() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return missCount;
+    }
+
+private:
+    using Order = std::list<std::pair<std::string, Entry>>;
+
+    void evict() {
+        while (order.size() > cap) {
+            index.erase(order.back().first);
+            order.pop_back();
+        }
+    }
+
+    mutable std::mutex mutex;
+    std::size_t cap;
+    std::size_t hitCount = 0;
+    std::size_t missCount = 0;
+    Order order;
+    std::unordered_map<std::string, Order::iterator> index;
+};
+
+}  // namespace complex_eval
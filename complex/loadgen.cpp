@@ -0,0 +1,198 @@
+// server 的压测客户端：多个连接并发发送同一表达式，每个连接保持固定深度的流水线，
+// 统计吞吐量与请求延迟。
+//
+// 构建：g++ loadgen.cpp -std=c++20 -O2 -pthread -o loadgen
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "socket_address.hpp"
+
+namespace ce = complex_eval;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    std::string address = "127.0.0.1:5555";
+    int clients = 8;
+    int requests = 10000;  // 每个连接
+    int depth = 16;        // 每个连接同时在途的请求数
+    std::string setup = "a = 3 + 4i";
+    std::string expr = "mod(con(a) * (1 - 2i))";
+};
+
+struct ClientResult {
+    std::vector<double> latenciesUs;
+    std::string firstResponse;
+    std::string error;
+};
+
+void sendAll(int fd, const std::string& data) {
+    std::size_t sent = 0;
+    while (sent < data.size()) {
+        const ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error(std::string("send: ") + std::strerror(errno));
+        }
+        sent += static_cast<std::size_t>(n);
+    }
+}
+
+// 应答以空行结束；setup 请求的应答不计入统计。
+void runClient(const ce::SocketAddress& addr, const Options& opt, ClientResult& result) {
+    const int fd = ::socket(addr.family(), SOCK_STREAM, 0);
+    if (fd < 0 || ::connect(fd, addr.get(), addr.length) < 0) {
+        result.error = std::string("connect: ") + std::strerror(errno);
+        if (fd >= 0) ::close(fd);
+        return;
+    }
+
+    try {
+        sendAll(fd, opt.setup + "\n");
+        const std::string request = opt.expr + "\n";
+        std::deque<Clock::time_point> inFlight;
+        int sentCount = 0;
+        int skip = 1;
+        int received = 0;
+        bool atLineStart = true;
+        std::string current;
+        char buf[64 * 1024];
+
+        result.latenciesUs.reserve(static_cast<std::size_t>(opt.requests));
+        while (received < opt.requests) {
+            std::string batch;
+            while (sentCount < opt.requests && static_cast<int>(inFlight.size()) < opt.depth) {
+                batch += request;
+                inFlight.push_back(Clock::now());
+                ++sentCount;
+            }
+            if (!batch.empty()) sendAll(fd, batch);
+
+            const ssize_t n = ::recv(fd, buf, sizeof(buf), 0);
+            if (n == 0) throw std::runtime_error("server closed the connection");
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                throw std::runtime_error(std::string("recv: ") + std::strerror(errno));
+            }
+            const auto now = Clock::now();
+            for (ssize_t k = 0; k < n; ++k) {
+                const char c = buf[k];
+                if (c != '\n') {
+                    atLineStart = false;
+                    if (result.firstResponse.empty() && skip == 0) current.push_back(c);
+                    continue;
+                }
+                if (!atLineStart) {
+                    atLineStart = true;
+                    continue;
+                }
+                // 空行：一条应答结束
+                if (skip > 0) {
+                    --skip;
+                    continue;
+                }
+                if (result.firstResponse.empty()) result.firstResponse = current;
+                std::chrono::duration<double, std::micro> dt = now - inFlight.front();
+                inFlight.pop_front();
+                result.latenciesUs.push_back(dt.count());
+                ++received;
+            }
+        }
+        sendAll(fd, "quit\n");
+    } catch (const std::exception& e) {
+        result.error = e.what();
+    }
+    ::close(fd);
+}
+
+double percentile(std::vector<double>& values, double p) {
+    if (values.empty()) return 0.0;
+    const auto k = static_cast<std::size_t>(p * static_cast<double>(values.size() - 1));
+    std::nth_element(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(k), values.end());
+    return values[k];
+}
+
+void printUsage(const char* prog) {
+    std::cout << "用法: " << prog << " [选项] [地址]\n"
+              << "选项:\n"
+              << "  -c N        并发连接数（默认 8）\n"
+              << "  -n N        每个连接的请求数（默认 10000）\n"
+              << "  -d N        每个连接的流水线深度（默认 16）\n"
+              << "  -s LINE     每个连接先发送的初始化请求（默认 \"a = 3 + 4i\"）\n"
+              << "  -e EXPR     压测使用的表达式\n"
+              << "  --help      显示此帮助信息\n";
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    Options opt;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "-c" && hasValue) {
+            opt.clients = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "-n" && hasValue) {
+            opt.requests = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "-d" && hasValue) {
+            opt.depth = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "-s" && hasValue) {
+            opt.setup = argv[++i];
+        } else if (arg == "-e" && hasValue) {
+            opt.expr = argv[++i];
+        } else if (arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        } else {
+            opt.address = arg;
+        }
+    }
+
+    ce::SocketAddress addr;
+    try {
+        addr = ce::parseSocketAddress(opt.address);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << '\n';
+        return 1;
+    }
+
+    std::vector<ClientResult> results(static_cast<std::size_t>(opt.clients));
+    std::vector<std::thread> threads;
+    const auto start = Clock::now();
+    for (auto& r : results) {
+        threads.emplace_back([&addr, &opt, &r] { runClient(addr, opt, r); });
+    }
+    for (auto& t : threads) t.join();
+    const std::chrono::duration<double> elapsed = Clock::now() - start;
+
+    std::vector<double> latencies;
+    for (const auto& r : results) {
+        if (!r.error.empty()) {
+            std::cerr << "Error: " << r.error << '\n';
+            return 1;
+        }
+        latencies.insert(latencies.end(), r.latenciesUs.begin(), r.latenciesUs.end());
+    }
+
+    std::cout << "应答示例: " << results.front().firstResponse << '\n'
+              << "请求总数: " << latencies.size() << "，耗时 " << elapsed.count() << " s\n"
+              << "吞吐量: " << static_cast<double>(latencies.size()) / elapsed.count() << " req/s\n"
+              << "延迟 p50: " << percentile(latencies, 0.50) << " us，p99: "
+              << percentile(latencies, 0.99) << " us\n";
+    return 0;
+}
@@ -1,98 +1,91 @@
-#include <algorithm>
+#include <cstdio>
 #include <iostream>
 #include <string>
-#include <unordered_map>
+#include <string_view>
 
-#include "big_complex.hpp"
-#include "calculator.hpp"
-#include "format.hpp"
-#include "scanner.hpp"
+#include "batch_io.hpp"
+#include "expr_cache.hpp"
+#include "session.hpp"
 
 namespace ce = complex_eval;
 
 namespace {
 
-ce::FormatConfig gFormat;
-
-std::string trim(const std::string& s) {
-    const std::string ws = " \t\n\r";
-    const std::size_t begin = s.find_first_not_of(ws);
-    if (begin == std::string::npos) {
-        return "";
-    }
-    const std::size_t end = s.find_last_not_of(ws);
-    return s.substr(begin, end - begin + 1);
+void printUsage(const char* prog) {
+    std::cout << "用法: " << prog << " [选项]\n"
+              << "选项:\n"
+              << "  -f FILE           以脚本模式执行 FILE（不显示提示符，输出整块缓冲）\n"
+              << "  --batch           以脚本模式执行标准输入\n"
+              << "  --help            显示此帮助信息\n"
+              << "不带选项时进入交互式 REPL，输入 help 查看命令。\n";
 }
 
-void printHelp() {
-    std::cout
-        << "命令:\n"
-        << "  help              显示帮助\n"
-        << "  format sci        使用科学计数法输出\n"
-        << "  format fixed      使用普通十进制输出（整数不带小数）\n"
-        << "  precision N       设置小数位数（sci 为小数点后 N 位；fixed 为小数点后 N 位）\n"
-        << "  quit / exit       退出\n"
-        << "表达式:\n"
-        << "  支持 + - * / ，赋值 = ，函数 con(z) 共轭、mod(z) 模长\n"
-        << "  支持复数字面量如 3.14、.5、1e10、2.5i、-i、i\n";
+int runInteractive(ce::Session& session) {
+    std::string line;
+    std::cout << ">>> ";
+    while (std::getline(std::cin, line)) {
+        if (!session.handleLine(line, std::cout, std::cerr)) {
+            break;
+        }
+        std::cout << ">>> ";
+    }
+    return 0;
 }
 
-bool handleCommand(const std::string& cmd) {
-    if (cmd == "help") {
-        printHelp();
-        return true;
-    }
-    if (cmd == "format sci") {
-        gFormat.sci = true;
-        std::cout << "已切换到科学计数法输出\n";
-        return true;
-    }
-    if (cmd == "format fixed") {
-        gFormat.sci = false;
-        std::cout << "已切换到普通十进制输出\n";
-        return true;
-    }
-    if (cmd.rfind("precision ", 0) == 0) {
-        const std::string value = trim(cmd.substr(10));
-        const int p = std::max(0, std::stoi(value));
-        gFormat.precision = p;
-        std::cout << "已设置小数位数为 " << p << '\n';
+// 脚本模式：无提示符，结果写入大块输出缓冲，错误带行号写到 stderr。
+// 有任何一行出错时返回 1。
+int runBatch(ce::Session& session, const std::string& path) {
+    ce::BufferedOutput outBuf(stdout);
+    std::ostream out(&outBuf);
+    auto onLine = [&](std::string_view line, std::size_t lineNo) {
+        return session.handleLine(line, out, std::cerr, lineNo);
+    };
+    // 管道输入中的超长行逐块交给流式词法分析，不在内存中拼出整行
+    auto onLongLine = [&](const auto& source, std::size_t lineNo) {
+        session.handleStreamedLine(source, out, std::cerr, lineNo);
         return true;
+    };
+
+    if (path.empty()) {
+        ce::forEachLineInStream(stdin, onLine, onLongLine, ce::Session::kStreamingLineBytes);
+    } else {
+        ce::forEachLineInFile(path, onLine, onLongLine, ce::Session::kStreamingLineBytes);
     }
-    return false;
+    out.flush();
+    return session.errorCount() == 0 ? 0 : 1;
 }
 
 }  // namespace
 
-int main() {
-    std::unordered_map<std::string, ce::Complex> variables;
-    std::string line;
-
-    std::cout << ">>> ";
-    while (std::getline(std::cin, line)) {
-        try {
-            const std::string cmd = trim(line);
-            if (cmd.empty()) {
-                std::cout << ">>> ";
-                continue;
-            }
-            if (cmd == "quit" || cmd == "exit") {
-                break;
-            }
-            if (handleCommand(cmd)) {
-                std::cout << ">>> ";
-                continue;
-            }
+int main(int argc, char* argv[]) {
+    bool batch = false;
+    std::string scriptPath;
 
-            const auto tokens = ce::scan(line);
-            ce::Complex result;
-            if (ce::evaluate(tokens, variables, result)) {
-                std::cout << ce::formatComplex(result, gFormat) << '\n';
-            }
-        } catch (const std::exception& e) {
-            std::cerr << "Error: " << e.what() << '\n';
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "-f" && i + 1 < argc) {
+            batch = true;
+            scriptPath = argv[++i];
+        } else if (arg == "--batch") {
+            batch = true;
+        } else if (arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        } else {
+            std::cerr << "错误: 未知参数 " << arg << "\n使用 --help 查看用法说明。\n";
+            return 1;
         }
-        std::cout << ">>> ";
     }
-    return 0;
+
+    ce::ExprCache cache;
+    ce::Session session(cache);
+    if (!batch) {
+        return runInteractive(session);
+    }
+    try {
+        return runBatch(session, scriptPath);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << '\n';
+        return 1;
+    }
 }
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define COMPLEX_EVAL_HAS_MMAP 1
+#endif
+
+namespace complex_eval {
+
+// 只读映射整个普通文件；没有 mmap 的平台退化为一次性读入内存。
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+#ifdef COMPLEX_EVAL_HAS_MMAP
+        fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot open file: " + path);
+        }
+        struct stat st {};
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Cannot stat file: " + path);
+        }
+        if (!S_ISREG(st.st_mode)) {
+            // 管道、FIFO 等的 st_size 为 0，映射会得到空内容，直接报错
+            ::close(fd);
+            throw std::runtime_error("Not a regular file: " + path);
+        }
+        length = static_cast<std::size_t>(st.st_size);
+        if (length > 0) {
+            void* p = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error("Cannot map file: " + path);
+            }
+            base = static_cast<const char*>(p);
+        }
+#else
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            throw std::runtime_error("Cannot open file: " + path);
+        }
+        buffer.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        base = buffer.data();
+        length = buffer.size();
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+#ifdef COMPLEX_EVAL_HAS_MMAP
+        if (base != nullptr) ::munmap(const_cast<char*>(base), length);
+        if (fd >= 0) ::close(fd);
+#endif
+    }
+
+    const char* data() const { return base; }
+    std::size_t size() const { return length; }
+
+private:
+    const char* base = nullptr;
+    std::size_t length = 0;
+#ifdef COMPLEX_EVAL_HAS_MMAP
+    int fd = -1;
+#else
+    std::vector<char> buffer;
+#endif
+};
+
+}  // namespace complex_eval
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "big_complex.hpp"
+
+namespace complex_eval {
+
+// sum/prod 使用的并行线程数：setting 为 0 时取 hardware_concurrency，且不超过它。
+// 多于核数的线程不会更快，只会在 threads 100000 这类设置下耗尽线程资源。
+inline unsigned reductionThreads(unsigned setting) {
+    const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    return setting == 0 ? cores : std::min(setting, cores);
+}
+
+namespace reduction_detail {
+
+// 每块至少包含的项数与最多的块数。分块只取决于区间长度，与线程数无关。
+constexpr unsigned long long kMinBlockTerms = 64;
+constexpr unsigned long long kMaxBlocks = 65536;
+
+// 嵌套的 sum/prod 在工作线程内顺序执行，避免线程数成倍膨胀。
+inline bool& insideParallelReduction() {
+    thread_local bool v = false;
+    return v;
+}
+
+template <class Combine>
+Complex treeReduce(std::vector<Complex>& partial, Combine& combine) {
+    for (std::size_t width = 1; width < partial.size(); width *= 2) {
+        for (std::size_t j = 0; j + width < partial.size(); j += 2 * width) {
+            partial[j] = combine(partial[j], partial[j + width]);
+        }
+    }
+    return partial.front();
+}
+
+}  // namespace reduction_detail
+
+// 对 k = lo..hi 计算 term(k) 并用 combine 归约，空区间返回 identity；最多使用 threads 个线程。
+// 区间按固定大小分块：块内顺序累积，块间按固定的二叉树两两合并。
+// 结合顺序只由区间决定，因此结果与线程数无关；各块可并行计算。
+// term 抛出的异常按块顺序取最靠前的一个重新抛出，与顺序求值报告的错误一致。
+template <class Term, class Combine>
+Complex parallelReduce(long long lo, long long hi, unsigned threads, const Complex& identity,
+                       Term&& term, Combine&& combine) {
+    using namespace reduction_detail;
+
+    if (lo > hi) return identity;
+
+    const unsigned long long count = static_cast<unsigned long long>(hi) -
+                                     static_cast<unsigned long long>(lo) + 1ULL;
+    const unsigned long long blockTerms = std::max(kMinBlockTerms, (count + kMaxBlocks - 1) / kMaxBlocks);
+    const std::size_t blocks = static_cast<std::size_t>((count + blockTerms - 1) / blockTerms);
+    std::vector<Complex> partial(blocks);
+    std::vector<std::exception_ptr> errors(blocks);
+
+    auto runBlock = [&](std::size_t b) {
+        const long long first = static_cast<long long>(static_cast<unsigned long long>(lo) + b * blockTerms);
+        const unsigned long long remaining = static_cast<unsigned long long>(hi) -
+                                             static_cast<unsigned long long>(first);
+        const long long last = remaining < blockTerms
+                                   ? hi
+                                   : static_cast<long long>(static_cast<unsigned long long>(first) + blockTerms - 1);
+        try {
+            Complex acc = term(first);
+            for (long long k = first + 1; k <= last; ++k) {
+                acc = combine(acc, term(k));
+            }
+            partial[b] = std::move(acc);
+        } catch (...) {
+            errors[b] = std::current_exception();
+        }
+    };
+
+    const std::size_t workers = insideParallelReduction()
+                                    ? 1
+                                    : std::min<std::size_t>(reductionThreads(threads), blocks);
+    if (workers <= 1) {
+        for (std::size_t b = 0; b < blocks; ++b) {
+            runBlock(b);
+            if (errors[b]) std::rethrow_exception(errors[b]);
+        }
+    } else {
+        std::atomic<std::size_t> next{0};
+        auto worker = [&] {
+            insideParallelReduction() = true;
+            for (std::size_t b; (b = next.fetch_add(1)) < blocks;) {
+                runBlock(b);
+            }
+            insideParallelReduction() = false;
+        };
+        // 创建线程失败（线程资源耗尽）时用已有的线程继续：块由 next 动态领取，少几个线程也能算完。
+        std::vector<std::thread> pool;
+        pool.reserve(workers - 1);
+        for (std::size_t t = 1; t < workers; ++t) {
+            try {
+                pool.emplace_back(worker);
+            } catch (const std::system_error&) {
+                break;
+            }
+        }
+        worker();
+        for (auto& t : pool) t.join();
+        for (const auto& e : errors) {
+            if (e) std::rethrow_exception(e);
+        }
+    }
+
+    return treeReduce(partial, combine);
+}
+
+}  // namespace complex_eval
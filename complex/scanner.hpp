@@ -1,34 +1,123 @@
 #pragma once
 
 #include <cctype>
-#include <regex>
-#include <stack>
+#include <cstddef>
+#include <deque>
+#include <functional>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 #include "token.hpp"
 
 namespace complex_eval {
 
-inline const std::regex& numberRegex() {
-    static const std::regex re(
-        R"(^(?:[+-]?(?:\d+(?:\.\d*)?|\.\d+)(?:[eE][+-]?\d+)?i?|i)$)"
-    );
-    return re;
+// 与正则 ^(?:[+-]?(?:\d+(?:\.\d*)?|\.\d+)(?:[eE][+-]?\d+)?i?|i)$ 等价的手写匹配，
+// 超长输入中每个数字都要判断一次，避免 std::regex 的开销。
+inline bool isNumberLiteral(const std::string& s) {
+    if (s == "i") return true;
+
+    const std::size_t n = s.size();
+    std::size_t k = 0;
+    auto digits = [&] {
+        const std::size_t start = k;
+        while (k < n && std::isdigit(static_cast<unsigned char>(s[k]))) ++k;
+        return k - start;
+    };
+
+    if (k < n && (s[k] == '+' || s[k] == '-')) ++k;
+    const std::size_t intDigits = digits();
+    std::size_t fracDigits = 0;
+    if (k < n && s[k] == '.') {
+        ++k;
+        fracDigits = digits();
+    }
+    if (intDigits == 0 && fracDigits == 0) return false;
+    if (k < n && (s[k] == 'e' || s[k] == 'E')) {
+        ++k;
+        if (k < n && (s[k] == '+' || s[k] == '-')) ++k;
+        if (digits() == 0) return false;
+    }
+    if (k < n && s[k] == 'i') ++k;
+    return k == n;
 }
 
-inline std::vector<Token> scan(const std::string& input) {
-    std::vector<Token> tokens;
-    std::stack<char> parens;
-    std::string current;
-    std::size_t currentPos = 0;
+// 流式词法分析：从 source 逐块取得输入，每次产出一个 token。
+// 除单个 token 的文本外不保留已读内容，因此内存占用与输入总长度无关。
+// source 每次返回下一块输入，返回空视图表示输入结束；视图需保持有效直到下一次调用。
+class TokenStream {
+public:
+    using Source = std::function<std::string_view()>;
+
+    explicit TokenStream(Source src) : source(std::move(src)) {}
+
+    // 从一段连续内存读取（不拷贝）。
+    static TokenStream fromView(std::string_view text) {
+        bool done = false;
+        return TokenStream([text, done]() mutable {
+            if (done) return std::string_view();
+            done = true;
+            return text;
+        });
+    }
+
+    // 取下一个 token；输入结束时返回 false，并在此时检查括号是否配对。
+    bool next(Token& out) {
+        while (ready.empty()) {
+            if (finished) return false;
+            pump();
+        }
+        out = std::move(ready.front());
+        ready.pop_front();
+        return true;
+    }
+
+private:
+    void pump() {
+        if (cursor == chunk.size()) {
+            chunk = source();
+            cursor = 0;
+            if (chunk.empty()) {
+                flushCurrent();
+                if (depth != 0) {
+                    throw std::runtime_error("Mismatched parentheses");
+                }
+                finished = true;
+                return;
+            }
+        }
 
-    auto flushCurrent = [&]() {
+        while (cursor < chunk.size() && ready.empty()) {
+            const char c = chunk[cursor++];
+            const std::size_t i = offset++;
+            if (std::isspace(static_cast<unsigned char>(c))) continue;
+
+            if (c == '+' || c == '-' || c == '*' || c == '/' || c == '=' || c == '(' || c == ')' ||
+                c == ',') {
+                flushCurrent();
+                if (c == '(') {
+                    ++depth;
+                } else if (c == ')') {
+                    if (depth == 0) {
+                        throw std::runtime_error("Unmatched ')' at pos " + std::to_string(i));
+                    }
+                    --depth;
+                }
+                ready.push_back(Token{Kind::OpTok, toOpChar(c), "", i});
+                continue;
+            }
+
+            if (current.empty()) currentPos = i;
+            current.push_back(c);
+        }
+    }
+
+    void flushCurrent() {
         if (current.empty()) return;
-        const auto& re = numberRegex();
-        if (std::regex_match(current, re)) {
-            tokens.push_back(Token{Kind::Number, Op{}, current, currentPos});
+        if (isNumberLiteral(current)) {
+            ready.push_back(Token{Kind::Number, Op{}, current, currentPos});
         } else {
             if (!(std::isalpha(static_cast<unsigned char>(current[0])) || current[0] == '_')) {
                 throw std::runtime_error("Invalid token: " + current);
@@ -38,47 +127,49 @@ inline std::vector<Token> scan(const std::string& input) {
                     throw std::runtime_error("Invalid ident: " + current);
                 }
             }
-            if (current == "i") {
-                tokens.push_back(Token{Kind::Number, Op{}, current, currentPos});
-            } else if (current == "con") {
-                tokens.push_back(Token{Kind::OpTok, Op::FnCon, "", currentPos});
+            if (current == "con") {
+                ready.push_back(Token{Kind::OpTok, Op::FnCon, "", currentPos});
             } else if (current == "mod") {
-                tokens.push_back(Token{Kind::OpTok, Op::FnMod, "", currentPos});
+                ready.push_back(Token{Kind::OpTok, Op::FnMod, "", currentPos});
+            } else if (current == "exp") {
+                ready.push_back(Token{Kind::OpTok, Op::FnExp, "", currentPos});
+            } else if (current == "log") {
+                ready.push_back(Token{Kind::OpTok, Op::FnLog, "", currentPos});
+            } else if (current == "sqrt") {
+                ready.push_back(Token{Kind::OpTok, Op::FnSqrt, "", currentPos});
+            } else if (current == "arg") {
+                ready.push_back(Token{Kind::OpTok, Op::FnArg, "", currentPos});
+            } else if (current == "pow") {
+                ready.push_back(Token{Kind::OpTok, Op::FnPow, "", currentPos});
+            } else if (current == "sum") {
+                ready.push_back(Token{Kind::OpTok, Op::FnSum, "", currentPos});
+            } else if (current == "prod") {
+                ready.push_back(Token{Kind::OpTok, Op::FnProd, "", currentPos});
             } else {
-                tokens.push_back(Token{Kind::Ident, Op{}, current, currentPos});
+                ready.push_back(Token{Kind::Ident, Op{}, current, currentPos});
             }
         }
         current.clear();
-    };
-
-    for (std::size_t i = 0; i < input.size(); ++i) {
-        char c = input[i];
-        if (std::isspace(static_cast<unsigned char>(c))) continue;
-
-        if (c == '+' || c == '-' || c == '*' || c == '/' || c == '=' || c == '(' || c == ')') {
-            flushCurrent();
-            if (c == '(') {
-                parens.push('(');
-            } else if (c == ')') {
-                if (parens.empty()) {
-                    throw std::runtime_error("Unmatched ')' at pos " + std::to_string(i));
-                }
-                parens.pop();
-            }
-            tokens.push_back(Token{Kind::OpTok, toOpChar(c), "", i});
-            continue;
-        }
-
-        if (current.empty()) currentPos = i;
-        current.push_back(c);
     }
 
-    flushCurrent();
+    Source source;
+    std::string_view chunk;
+    std::size_t cursor = 0;
+    std::size_t offset = 0;
+    std::string current;
+    std::size_t currentPos = 0;
+    std::size_t depth = 0;
+    std::deque<Token> ready;
+    bool finished = false;
+};
 
-    if (!parens.empty()) {
-        throw std::runtime_error("Mismatched parentheses");
+inline std::vector<Token> scan(const std::string& input) {
+    TokenStream stream = TokenStream::fromView(input);
+    std::vector<Token> tokens;
+    Token tk;
+    while (stream.next(tk)) {
+        tokens.push_back(std::move(tk));
     }
-
     return tokens;
 }
 
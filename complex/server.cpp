@@ -0,0 +1,484 @@
+// 本地求值服务器：epoll 事件循环负责收发，线程池负责求值。
+// 每个连接拥有独立的 Session（变量与输出格式），表达式缓存全局共享。
+//
+// 协议：每行一个请求（与 REPL 输入相同），可以连续发送多行（流水线）。
+// 服务器按顺序对每个请求写回 REPL 的输出，再以一个空行结束该请求的应答；
+// 赋值等没有输出的请求只返回空行。quit / exit 会在发送完已有应答后关闭连接。
+// save / load 与 cache size / cache clear 在服务器上不可用；单行请求超过 1 MiB 时
+// 返回错误并关闭连接。
+//
+// 构建：g++ server.cpp -std=c++20 -O2 -pthread -o server
+
+#include <fcntl.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "expr_cache.hpp"
+#include "reduction.hpp"
+#include "session.hpp"
+#include "socket_address.hpp"
+#include "thread_pool.hpp"
+
+namespace ce = complex_eval;
+
+namespace {
+
+constexpr std::size_t kReadChunk = 64 * 1024;
+// 客户端只发不收时，待发送数据超过该值就暂停读取，避免无限堆积。
+constexpr std::size_t kMaxBufferedOutput = 4 * 1024 * 1024;
+// 尚未收到换行的请求最多缓存这么多字节，超过即视为协议错误。
+constexpr std::size_t kMaxRequestLine = 1024 * 1024;
+// 待求值的请求与尚未取走的应答合计超过该值时暂停读取，等工作线程追上。
+constexpr std::size_t kMaxBacklog = 4 * 1024 * 1024;
+// 工作线程每次最多处理这么多行，处理完先交出应答，再重新排队处理其余请求。
+constexpr std::size_t kMaxBatchLines = 64;
+
+std::atomic<bool> gStop{false};
+
+void onSignal(int) { gStop = true; }
+
+void setNonBlocking(int fd) {
+    const int flags = ::fcntl(fd, F_GETFL, 0);
+    if (flags < 0 || ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+        throw std::runtime_error(std::string("fcntl: ") + std::strerror(errno));
+    }
+}
+
+struct Connection {
+    Connection(int socket, ce::ExprCache& cache, const ce::SessionPolicy& policy)
+        : fd(socket), session(cache, policy) {}
+
+    const int fd;
+    ce::Session session;  // 同一时刻只有一个工作线程持有
+
+    // 只由事件循环线程访问
+    std::string inBuf;
+    std::string sendBuf;
+    bool peerClosed = false;
+    bool overlong = false;    // 收到超长的请求行，不再读取，回复错误后关闭
+    bool registered = true;   // 是否仍在 epoll 中
+    std::uint32_t events = 0;
+
+    // 以下由 m 保护，在事件循环与工作线程之间传递
+    std::mutex m;
+    std::deque<std::string> pending;
+    std::size_t pendingBytes = 0;
+    std::string outBuf;
+    bool scheduled = false;
+    bool quit = false;
+    bool closed = false;  // 连接已关闭，工作线程丢弃剩余请求
+};
+
+using ConnPtr = std::shared_ptr<Connection>;
+
+class Server {
+public:
+    // 服务器会话不能读写服务器上的文件，也不能修改所有连接共享的缓存。
+    // 所有工作线程可能同时在算 sum/prod，因此把 CPU 核数平分给它们：
+    // 每个请求最多 max(1, 核数 / 工作线程数) 个线程，合计不超过核数（工作线程多于核数时每个 1 个）。
+    Server(const ce::SocketAddress& address, std::size_t threads)
+        : addr(address),
+          policy{false, false, std::max(1u, ce::reductionThreads(0) / static_cast<unsigned>(threads))},
+          pool(threads) {
+        listenFd = ::socket(addr.family(), SOCK_STREAM, 0);
+        if (listenFd < 0) fail("socket");
+        if (addr.family() == AF_UNIX) {
+            removeStaleSocket();
+        } else {
+            const int on = 1;
+            ::setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        }
+        if (::bind(listenFd, addr.get(), addr.length) < 0) fail("bind");
+        if (addr.family() == AF_UNIX) {
+            struct stat st {};
+            if (::lstat(addr.unixPath.c_str(), &st) == 0) socketFile = st;
+        }
+        if (::listen(listenFd, SOMAXCONN) < 0) fail("listen");
+        setNonBlocking(listenFd);
+
+        wakeFd = ::eventfd(0, EFD_NONBLOCK);
+        if (wakeFd < 0) fail("eventfd");
+        epollFd = ::epoll_create1(0);
+        if (epollFd < 0) fail("epoll_create1");
+        watch(listenFd, EPOLLIN);
+        watch(wakeFd, EPOLLIN);
+    }
+
+    ~Server() {
+        // 先让排队中的求值全部作废，join 只需等待正在计算的那一行
+        for (auto& [fd, c] : conns) {
+            std::lock_guard<std::mutex> lock(c->m);
+            c->closed = true;
+        }
+        pool.join();
+        for (auto& [fd, c] : conns) ::close(fd);
+        ::close(epollFd);
+        ::close(wakeFd);
+        ::close(listenFd);
+        if (addr.family() == AF_UNIX) {
+            // 只删除自己创建的套接字文件，路径已被替换成别的文件时保留
+            struct stat st {};
+            if (::lstat(addr.unixPath.c_str(), &st) == 0 && S_ISSOCK(st.st_mode) &&
+                st.st_dev == socketFile.st_dev && st.st_ino == socketFile.st_ino) {
+                ::unlink(addr.unixPath.c_str());
+            }
+        }
+    }
+
+    void run() {
+        std::vector<epoll_event> events(256);
+        while (!gStop) {
+            const int n = ::epoll_wait(epollFd, events.data(), static_cast<int>(events.size()), -1);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                fail("epoll_wait");
+            }
+            for (int k = 0; k < n; ++k) {
+                const int fd = events[k].data.fd;
+                if (fd == listenFd) {
+                    acceptAll();
+                } else if (fd == wakeFd) {
+                    drainReady();
+                } else {
+                    auto it = conns.find(fd);
+                    if (it == conns.end()) continue;
+                    ConnPtr c = it->second;
+                    // 对端关闭后不再读取；此时 EPOLLHUP 仍会上报，交给 flush 处理或在 updateEvents 中摘除 fd
+                    const bool reading = !c->peerClosed && !c->overlong;
+                    if (reading && (events[k].events & (EPOLLIN | EPOLLHUP | EPOLLERR))) onReadable(c);
+                    if (conns.count(fd) && (events[k].events & EPOLLOUT)) flush(c);
+                }
+            }
+        }
+    }
+
+private:
+    [[noreturn]] static void fail(const char* what) {
+        throw std::runtime_error(std::string(what) + ": " + std::strerror(errno));
+    }
+
+    // 绑定前清理上次异常退出留下的套接字文件。路径上是普通文件等其他类型、
+    // 或者已有服务器在监听时直接报错，不删除任何东西。
+    void removeStaleSocket() {
+        struct stat st {};
+        if (::lstat(addr.unixPath.c_str(), &st) < 0) {
+            if (errno == ENOENT) return;
+            fail("lstat");
+        }
+        if (!S_ISSOCK(st.st_mode)) {
+            throw std::runtime_error("Address in use and not a socket: " + addr.unixPath);
+        }
+        const int probe = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (probe < 0) fail("socket");
+        const bool live = ::connect(probe, addr.get(), addr.length) == 0;
+        ::close(probe);
+        if (live) throw std::runtime_error("Address in use: " + addr.unixPath);
+        ::unlink(addr.unixPath.c_str());
+    }
+
+    void watch(int fd, std::uint32_t events) {
+        epoll_event ev{};
+        ev.events = events;
+        ev.data.fd = fd;
+        if (::epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) < 0) fail("epoll_ctl");
+    }
+
+    void acceptAll() {
+        for (;;) {
+            const int fd = ::accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                if (errno == EINTR) continue;
+                return;  // EAGAIN 或暂时性错误（如 EMFILE），等下一次事件
+            }
+            if (addr.family() == AF_INET) {
+                const int on = 1;
+                ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+            }
+            auto c = std::make_shared<Connection>(fd, cache, policy);
+            c->events = EPOLLIN;
+            watch(fd, c->events);
+            conns.emplace(fd, std::move(c));
+        }
+    }
+
+    void onReadable(const ConnPtr& c) {
+        char buf[kReadChunk];
+        for (;;) {
+            const ssize_t n = ::recv(c->fd, buf, sizeof(buf), 0);
+            if (n > 0) {
+                c->inBuf.append(buf, static_cast<std::size_t>(n));
+                if (c->inBuf.size() > kMaxRequestLine) break;  // 先处理已收到的，其余等下一次事件
+                continue;
+            }
+            if (n == 0) {
+                c->peerClosed = true;
+                break;
+            }
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            closeConnection(c);
+            return;
+        }
+
+        std::deque<std::string> lines;
+        std::size_t start = 0;
+        for (std::size_t nl; (nl = c->inBuf.find('\n', start)) != std::string::npos; start = nl + 1) {
+            lines.emplace_back(c->inBuf, start, nl - start);
+        }
+        c->inBuf.erase(0, start);
+        if (c->inBuf.size() > kMaxRequestLine) {
+            std::string().swap(c->inBuf);
+            c->overlong = true;
+            // 丢弃已到达的剩余输入：关闭时接收队列里还有数据会触发 RST，客户端就收不到错误信息
+            for (std::size_t dropped = 0; dropped < kMaxRequestLine;) {
+                const ssize_t n = ::recv(c->fd, buf, sizeof(buf), 0);
+                if (n <= 0) break;
+                dropped += static_cast<std::size_t>(n);
+            }
+        } else if (c->peerClosed && !c->inBuf.empty()) {
+            lines.push_back(std::move(c->inBuf));  // 最后一行可以不带换行
+            c->inBuf.clear();
+        }
+
+        if (!lines.empty()) {
+            bool submit = false;
+            {
+                std::lock_guard<std::mutex> lock(c->m);
+                if (!c->quit) {
+                    for (auto& line : lines) {
+                        c->pendingBytes += line.size();
+                        c->pending.push_back(std::move(line));
+                    }
+                    submit = !c->scheduled;
+                    c->scheduled = true;
+                }
+            }
+            if (submit) pool.submit([this, c] { work(c); });
+        }
+
+        updateEvents(c);
+        maybeClose(c);
+    }
+
+    // 工作线程：按顺序处理该连接的一批请求，交出应答后若还有积压就重新排队，
+    // 让持续流水线的客户端也能陆续收到应答，且不会长期占住一个工作线程。
+    void work(const ConnPtr& c) {
+        std::deque<std::string> lines;
+        {
+            std::lock_guard<std::mutex> lock(c->m);
+            if (c->closed) {
+                c->pending.clear();
+                c->pendingBytes = 0;
+                c->scheduled = false;
+                return;
+            }
+            while (!c->pending.empty() && lines.size() < kMaxBatchLines) {
+                c->pendingBytes -= c->pending.front().size();
+                lines.push_back(std::move(c->pending.front()));
+                c->pending.pop_front();
+            }
+        }
+
+        std::ostringstream out;
+        bool quit = false;
+        for (const auto& line : lines) {
+            if (!c->session.handleLine(line, out, out)) {
+                quit = true;
+                break;
+            }
+            out << '\n';
+        }
+
+        bool more = false;
+        {
+            std::lock_guard<std::mutex> lock(c->m);
+            c->outBuf += out.str();
+            if (quit) c->quit = true;
+            more = !c->pending.empty() && !c->quit && !c->closed;
+            if (!more) {
+                c->pending.clear();
+                c->pendingBytes = 0;
+                c->scheduled = false;
+            }
+        }
+        notify(c);
+        if (more) pool.submit([this, c] { work(c); });
+    }
+
+    void notify(const ConnPtr& c) {
+        {
+            std::lock_guard<std::mutex> lock(readyMutex);
+            ready.push_back(c);
+        }
+        const std::uint64_t one = 1;
+        (void)::write(wakeFd, &one, sizeof(one));
+    }
+
+    void drainReady() {
+        std::uint64_t counter;
+        while (::read(wakeFd, &counter, sizeof(counter)) > 0) {
+        }
+        std::vector<ConnPtr> batch;
+        {
+            std::lock_guard<std::mutex> lock(readyMutex);
+            batch.swap(ready);
+        }
+        for (const auto& c : batch) {
+            auto it = conns.find(c->fd);
+            if (it == conns.end() || it->second != c) continue;  // 已关闭，fd 可能已被复用
+            flush(c);
+        }
+    }
+
+    void flush(const ConnPtr& c) {
+        {
+            std::lock_guard<std::mutex> lock(c->m);
+            c->sendBuf += c->outBuf;
+            c->outBuf.clear();
+        }
+        std::size_t sent = 0;
+        while (sent < c->sendBuf.size()) {
+            const ssize_t n = ::send(c->fd, c->sendBuf.data() + sent, c->sendBuf.size() - sent,
+                                     MSG_NOSIGNAL);
+            if (n > 0) {
+                sent += static_cast<std::size_t>(n);
+                continue;
+            }
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+            closeConnection(c);
+            return;
+        }
+        c->sendBuf.erase(0, sent);
+        updateEvents(c);
+        maybeClose(c);
+    }
+
+    // 没有要等待的事件时把 fd 从 epoll 中摘除：EPOLLHUP 无法屏蔽，
+    // 对端已关闭而工作线程仍在求值时，留在 epoll 中会让事件循环空转。
+    void updateEvents(const ConnPtr& c) {
+        bool backlogged;
+        {
+            std::lock_guard<std::mutex> lock(c->m);
+            backlogged = c->pendingBytes + c->outBuf.size() >= kMaxBacklog;
+        }
+        std::uint32_t events = 0;
+        if (!c->peerClosed && !c->overlong && !backlogged && c->sendBuf.size() < kMaxBufferedOutput) {
+            events |= EPOLLIN;
+        }
+        if (!c->sendBuf.empty()) events |= EPOLLOUT;
+        if (events == c->events && (events != 0) == c->registered) return;
+        c->events = events;
+        if (events == 0) {
+            ::epoll_ctl(epollFd, EPOLL_CTL_DEL, c->fd, nullptr);
+            c->registered = false;
+            return;
+        }
+        epoll_event ev{};
+        ev.events = events;
+        ev.data.fd = c->fd;
+        ::epoll_ctl(epollFd, c->registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, c->fd, &ev);
+        c->registered = true;
+    }
+
+    void maybeClose(const ConnPtr& c) {
+        if (!c->sendBuf.empty()) return;
+        {
+            std::lock_guard<std::mutex> lock(c->m);
+            if (c->scheduled || !c->outBuf.empty()) return;
+            if (!c->quit && !c->overlong && !(c->peerClosed && c->pending.empty())) return;
+        }
+        if (c->overlong) {
+            // 之前的应答都已发出，补上错误信息，发送完毕后由 flush 再次进入这里关闭
+            c->overlong = false;
+            c->peerClosed = true;
+            c->sendBuf = "Error: Request line too long\n\n";
+            flush(c);
+            return;
+        }
+        closeConnection(c);
+    }
+
+    void closeConnection(const ConnPtr& c) {
+        if (conns.erase(c->fd) == 0) return;
+        {
+            std::lock_guard<std::mutex> lock(c->m);
+            c->closed = true;
+        }
+        if (c->registered) ::epoll_ctl(epollFd, EPOLL_CTL_DEL, c->fd, nullptr);
+        ::close(c->fd);
+    }
+
+    ce::SocketAddress addr;
+    struct stat socketFile {};  // bind 创建的套接字文件，析构时据此确认再删除
+    int listenFd = -1;
+    int wakeFd = -1;
+    int epollFd = -1;
+    ce::SessionPolicy policy;
+    ce::ExprCache cache;
+    std::unordered_map<int, ConnPtr> conns;
+    std::mutex readyMutex;
+    std::vector<ConnPtr> ready;
+    ce::ThreadPool pool;
+};
+
+void printUsage(const char* prog) {
+    std::cout << "用法: " << prog << " [-t 线程数] [地址]\n"
+              << "地址:\n"
+              << "  unix:/path/to/socket   Unix 域套接字\n"
+              << "  HOST:PORT 或 PORT      IPv4 回环地址（默认 127.0.0.1:5555）\n";
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    std::string address = "127.0.0.1:5555";
+    std::size_t threads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "-t" && i + 1 < argc) {
+            threads = static_cast<std::size_t>(std::max(1, std::stoi(argv[++i])));
+        } else if (arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        } else {
+            address = arg;
+        }
+    }
+
+    struct sigaction sa {};
+    sa.sa_handler = onSignal;
+    ::sigaction(SIGINT, &sa, nullptr);
+    ::sigaction(SIGTERM, &sa, nullptr);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    try {
+        Server server(ce::parseSocketAddress(address), threads);
+        std::cout << "正在监听 " << address << "，工作线程 " << threads << " 个" << std::endl;
+        server.run();
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
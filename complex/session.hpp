@@ -0,0 +1,221 @@
+#pragma once
+
+#include <algorithm>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "big_complex.hpp"
+#include "calculator.hpp"
+#include "expr_cache.hpp"
+#include "format.hpp"
+#include "reduction.hpp"
+#include "snapshot.hpp"
+
+namespace complex_eval {
+
+inline std::string_view trimView(std::string_view s) {
+    const std::string_view ws = " \t\n\r";
+    const std::size_t begin = s.find_first_not_of(ws);
+    if (begin == std::string_view::npos) {
+        return {};
+    }
+    const std::size_t end = s.find_last_not_of(ws);
+    return s.substr(begin, end - begin + 1);
+}
+
+inline std::string trim(const std::string& s) {
+    return std::string(trimView(s));
+}
+
+// 会话允许的命令范围。服务器的会话面对任意本地客户端：
+// 不允许读写文件，也不允许修改所有连接共享的表达式缓存。
+struct SessionPolicy {
+    bool allowFiles = true;        // save / load
+    bool allowCacheControl = true;  // cache size / cache clear
+    unsigned maxThreads = 0;        // sum/prod 线程数上限，0 为不限
+};
+
+// 一个求值会话：变量环境与输出格式各自独立，表达式缓存可在多个会话间共享。
+// REPL 使用一个会话，服务器为每个连接创建一个会话。
+class Session {
+public:
+    // 超过这个长度的行（通常是生成的大表达式）不进缓存，直接流式求值，
+    // 既不拷贝整行，也不保存整个 token 序列。
+    static constexpr std::size_t kStreamingLineBytes = 64 * 1024;
+
+    explicit Session(ExprCache& sharedCache, SessionPolicy sessionPolicy = {})
+        : cache(sharedCache), policy(sessionPolicy) {}
+
+    // 处理一行输入：结果与命令回显写入 out，错误写入 err。
+    // lineNo 非 0 时（脚本模式）错误信息带上行号。返回 false 表示收到 quit / exit。
+    bool handleLine(std::string_view line, std::ostream& out, std::ostream& err,
+                    std::size_t lineNo = 0) {
+        try {
+            const std::string_view text = trimView(line);
+            if (text.empty()) {
+                return true;
+            }
+            if (text.size() > kStreamingLineBytes) {
+                TokenStream stream = TokenStream::fromView(text);
+                evaluateStream(stream, out);
+                return true;
+            }
+
+            const std::string cmd(text);
+            if (cmd == "quit" || cmd == "exit") {
+                return false;
+            }
+            if (handleCommand(cmd, out)) {
+                return true;
+            }
+
+            const auto expr = cache.get(cmd);
+            Complex result;
+            if (evaluate(*expr, variables, result, reductionThreadCount())) {
+                out << formatComplex(result, format) << '\n';
+            }
+        } catch (const std::exception& e) {
+            reportError(err, lineNo, e);
+        }
+        return true;
+    }
+
+    // 处理一条只能逐段读取的超长行（来自管道等无法整体映射的输入）：
+    // source 依次返回该行的各段，空视图表示行结束。按表达式流式求值，不进缓存。
+    void handleStreamedLine(TokenStream::Source source, std::ostream& out, std::ostream& err,
+                            std::size_t lineNo = 0) {
+        try {
+            TokenStream stream(std::move(source));
+            evaluateStream(stream, out);
+        } catch (const std::exception& e) {
+            reportError(err, lineNo, e);
+        }
+    }
+
+    std::size_t errorCount() const { return errors; }
+
+    static void printHelp(std::ostream& out) {
+        out
+            << "命令:\n"
+            << "  help              显示帮助\n"
+            << "  format sci        使用科学计数法输出\n"
+            << "  format fixed      使用普通十进制输出（整数不带小数）\n"
+            << "  precision N       设置小数位数（sci 为小数点后 N 位；fixed 为小数点后 N 位）\n"
+            << "  save FILE         将全部变量与已编译表达式保存为二进制快照\n"
+            << "  load FILE         从二进制快照加载变量与已编译表达式（覆盖同名变量）\n"
+            << "  cache             显示表达式缓存的容量与命中/未命中次数\n"
+            << "  cache size N      设置表达式缓存容量（0 为禁用）\n"
+            << "  cache clear       清空表达式缓存与计数\n"
+            << "  threads N         设置 sum/prod 的并行线程数（0 或超过核数时按 CPU 核数）\n"
+            << "  quit / exit       退出\n"
+            << "表达式:\n"
+            << "  支持 + - * / ，赋值 = ，函数 con(z) 共轭、mod(z) 模长\n"
+            << "  exp(z)、log(z)、sqrt(z)、arg(z)（主值），pow(z, n) 整数次幂\n"
+            << "  sum(k, a, b, expr)、prod(k, a, b, expr) 对整数 k = a..b 求和/求积\n"
+            << "  支持复数字面量如 3.14、.5、1e10、2.5i、-i、i\n";
+    }
+
+private:
+    void evaluateStream(TokenStream& stream, std::ostream& out) {
+        Complex result;
+        if (evaluate(stream, variables, result, reductionThreadCount())) {
+            out << formatComplex(result, format) << '\n';
+        }
+    }
+
+    void reportError(std::ostream& err, std::size_t lineNo, const std::exception& e) {
+        ++errors;
+        err << "Error";
+        if (lineNo != 0) err << " (line " << lineNo << ')';
+        err << ": " << e.what() << '\n';
+    }
+
+    bool handleCommand(const std::string& cmd, std::ostream& out) {
+        if (cmd == "help") {
+            printHelp(out);
+            return true;
+        }
+        if (cmd == "format sci") {
+            format.sci = true;
+            out << "已切换到科学计数法输出\n";
+            return true;
+        }
+        if (cmd == "format fixed") {
+            format.sci = false;
+            out << "已切换到普通十进制输出\n";
+            return true;
+        }
+        if (cmd.rfind("precision ", 0) == 0) {
+            const std::string value = trim(cmd.substr(10));
+            const int p = std::max(0, std::stoi(value));
+            format.precision = p;
+            out << "已设置小数位数为 " << p << '\n';
+            return true;
+        }
+        if (cmd.rfind("save ", 0) == 0) {
+            requireAllowed(policy.allowFiles, "save");
+            const std::string path = trim(cmd.substr(5));
+            const auto n = saveSnapshot(path, variables, &cache);
+            out << "已保存 " << n.variables << " 个变量、" << n.expressions
+                << " 条表达式到 " << path << '\n';
+            return true;
+        }
+        if (cmd.rfind("load ", 0) == 0) {
+            requireAllowed(policy.allowFiles, "load");
+            const std::string path = trim(cmd.substr(5));
+            const auto n = loadSnapshot(path, variables, &cache);
+            out << "已从 " << path << " 加载 " << n.variables << " 个变量、"
+                << n.expressions << " 条表达式\n";
+            return true;
+        }
+        if (cmd == "cache") {
+            out << "缓存: " << cache.size() << '/' << cache.capacity()
+                << "，命中 " << cache.hits() << "，未命中 " << cache.misses() << '\n';
+            return true;
+        }
+        if (cmd == "cache clear") {
+            requireAllowed(policy.allowCacheControl, "cache clear");
+            cache.clear();
+            out << "已清空表达式缓存\n";
+            return true;
+        }
+        if (cmd.rfind("cache size ", 0) == 0) {
+            requireAllowed(policy.allowCacheControl, "cache size");
+            const std::string value = trim(cmd.substr(11));
+            const int n = std::max(0, std::stoi(value));
+            cache.setCapacity(static_cast<std::size_t>(n));
+            out << "已设置表达式缓存容量为 " << n << '\n';
+            return true;
+        }
+        if (cmd.rfind("threads ", 0) == 0) {
+            const std::string value = trim(cmd.substr(8));
+            const int n = std::max(0, std::stoi(value));
+            threadSetting = static_cast<unsigned>(n);
+            out << "sum/prod 并行线程数: " << reductionThreadCount() << '\n';
+            return true;
+        }
+        return false;
+    }
+
+    unsigned reductionThreadCount() const {
+        const unsigned n = reductionThreads(threadSetting);
+        return policy.maxThreads != 0 ? std::min(n, policy.maxThreads) : n;
+    }
+
+    static void requireAllowed(bool allowed, const char* command) {
+        if (!allowed) {
+            throw std::runtime_error(std::string("Command not available in this session: ") + command);
+        }
+    }
+
+    ExprCache& cache;
+    SessionPolicy policy;
+    FormatConfig format;
+    std::unordered_map<std::string, Complex> variables;
+    unsigned threadSetting = 0;  // threads N 的设置，只影响本会话
+    std::size_t errors = 0;
+};
+
+}  // namespace complex_eval
@@ -0,0 +1,372 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "big_complex.hpp"
+#include "calculator.hpp"
+#include "expr_cache.hpp"
+#include "mapped_file.hpp"
+
+namespace complex_eval {
+
+// 快照文件布局（本机字节序，加载时校验）：
+//   magic[8] | version u32 | byteOrder u32 | bigRecordSize u32 | reserved u32 | varCount u64
+//   每个变量：nameLen u32 | name 字节 | real 记录 | imag 记录
+//   exprCount u64，随后每条缓存表达式（按最久未使用在前）：
+//     keyLen u32 | key 字节 | tokenCount u32 | 每个 token: kind u8, op u8, pos u64, lexLen u32, lex
+//     | literalCount u32 | 每个字面量: real 记录 | imag 记录
+//   checksum u64：之前全部字节的 FNV-1a 64 位散列
+// Big 记录直接保存 cpp_dec_float 的内部数位与指数，加载时不经过十进制字符串解析，
+// 但每个字段都会校验，损坏或伪造的文件只会被拒绝，不会把非法状态装进后端。
+namespace snapshot_detail {
+
+constexpr char kMagic[8] = {'C', 'E', 'S', 'N', 'A', 'P', '\0', '\0'};
+constexpr std::uint32_t kVersion = 4;
+constexpr std::uint32_t kByteOrderMark = 0x01020304u;
+
+struct ByteWriter {
+    std::string& out;
+
+    template <class T>
+    ByteWriter& operator&(const boost::serialization::nvp<T>& item) {
+        static_assert(std::is_trivially_copyable<T>::value, "raw snapshot field");
+        put(item.const_value());
+        return *this;
+    }
+
+    template <class T>
+    void put(const T& value) {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+};
+
+struct ByteReader {
+    const char* cur;
+    const char* end;
+
+    template <class T>
+    ByteReader& operator&(const boost::serialization::nvp<T>& item) {
+        static_assert(std::is_trivially_copyable<T>::value, "raw snapshot field");
+        item.value() = get<T>();
+        return *this;
+    }
+
+    template <class T>
+    T get() {
+        need(sizeof(T));
+        T value;
+        std::memcpy(&value, cur, sizeof(T));
+        cur += sizeof(T);
+        return value;
+    }
+
+    std::string str(std::uint32_t n) {
+        need(n);
+        std::string s(cur, n);
+        cur += n;
+        return s;
+    }
+
+    std::size_t remaining() const { return static_cast<std::size_t>(end - cur); }
+
+    void need(std::size_t n) const {
+        if (remaining() < n) {
+            throw std::runtime_error("Snapshot is truncated");
+        }
+    }
+
+    // 条目数来自文件，先按每条的最小字节数核对剩余长度，再据此分配内存。
+    void checkCount(std::uint64_t count, std::size_t minBytesEach) const {
+        if (count > remaining() / minBytesEach) {
+            throw std::runtime_error("Snapshot is corrupt");
+        }
+    }
+};
+
+inline std::uint64_t fnv1a(const char* data, std::size_t size) {
+    std::uint64_t h = 0xcbf29ce484222325ULL;
+    for (std::size_t k = 0; k < size; ++k) {
+        h ^= static_cast<unsigned char>(data[k]);
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+// cpp_dec_float 每个数位（limb）保存 8 位十进制数，取值 0 .. 10^8-1。
+constexpr std::uint32_t kLimbBase = 100000000u;
+constexpr long long kLimbDigits = 8;
+
+// 逐字段读取一条 Big 记录并校验：数位 < 10^8，指数是 8 的倍数且在后端范围内，
+// 符号为 0/1，类别为 finite/inf/NaN，精度在 2 与数位个数之间，非零有限值的首个数位不为 0。
+struct BigRecordReader {
+    ByteReader& in;
+    std::uint32_t limbs = 0;
+    bool leadingZero = false;
+    bool anyNonZero = false;
+    long long fpclass = 0;
+
+    template <class T>
+    BigRecordReader& operator&(const boost::serialization::nvp<T>& item) {
+        if constexpr (std::is_same_v<T, bool>) {
+            const auto b = in.get<std::uint8_t>();
+            if (b > 1) corrupt();
+            item.value() = (b != 0);
+        } else if constexpr (std::is_enum_v<T>) {
+            fpclass = static_cast<long long>(in.get<std::underlying_type_t<T>>());
+            if (fpclass < 0 || fpclass > 2) corrupt();
+            item.value() = static_cast<T>(fpclass);
+        } else {
+            static_assert(std::is_integral_v<T>, "raw snapshot field");
+            const T value = in.get<T>();
+            check(std::string_view(item.name()), static_cast<long long>(value));
+            item.value() = value;
+        }
+        return *this;
+    }
+
+    void check(std::string_view name, long long value) {
+        using Backend = Big::backend_type;
+        if (name == "digit") {
+            if (value < 0 || value >= kLimbBase) corrupt();
+            if (limbs++ == 0) leadingZero = (value == 0);
+            anyNonZero = anyNonZero || value != 0;
+        } else if (name == "exponent") {
+            if (value % kLimbDigits != 0 ||
+                value > static_cast<long long>(Backend::cpp_dec_float_max_exp10) ||
+                value < static_cast<long long>(Backend::cpp_dec_float_min_exp10)) {
+                corrupt();
+            }
+        } else if (name == "precision") {
+            if (value < 2 || value > static_cast<long long>(limbs)) corrupt();
+        } else {
+            corrupt();
+        }
+    }
+
+    // 所有字段读完之后的整体校验。
+    void finish() const {
+        if (fpclass == 0 && leadingZero && anyNonZero) corrupt();
+    }
+
+    [[noreturn]] static void corrupt() {
+        throw std::runtime_error("Snapshot is corrupt");
+    }
+};
+
+inline void writeBig(ByteWriter& w, const Big& value) {
+    // serialize() 不是 const 成员，拷贝一份再写出。
+    Big copy = value;
+    copy.backend().serialize(w, 0);
+}
+
+inline Big readBig(ByteReader& r) {
+    Big value;
+    BigRecordReader checked{r};
+    value.backend().serialize(checked, 0);
+    checked.finish();
+    return value;
+}
+
+inline void writeComplex(ByteWriter& w, const Complex& value) {
+    writeBig(w, value.realPart());
+    writeBig(w, value.imagPart());
+}
+
+inline Complex readComplex(ByteReader& r) {
+    Big re = readBig(r);
+    Big im = readBig(r);
+    return Complex(re, im);
+}
+
+inline void writeString(ByteWriter& w, const std::string& s) {
+    w.put(static_cast<std::uint32_t>(s.size()));
+    w.out.append(s);
+}
+
+inline void writeCompiled(ByteWriter& w, const CompiledExpr& expr) {
+    w.put(static_cast<std::uint32_t>(expr.tokens.size()));
+    for (const Token& tk : expr.tokens) {
+        w.put(static_cast<std::uint8_t>(tk.kind));
+        w.put(static_cast<std::uint8_t>(tk.op));
+        w.put(static_cast<std::uint64_t>(tk.pos));
+        writeString(w, tk.lex);
+    }
+    w.put(static_cast<std::uint32_t>(expr.literals.size()));
+    for (const Complex& c : expr.literals) {
+        writeComplex(w, c);
+    }
+}
+
+inline CompiledExpr readCompiled(ByteReader& r, std::uint32_t recordSize) {
+    CompiledExpr expr;
+    const auto tokenCount = r.get<std::uint32_t>();
+    r.checkCount(tokenCount, 1 + 1 + 8 + 4);
+    expr.tokens.reserve(tokenCount);
+    for (std::uint32_t k = 0; k < tokenCount; ++k) {
+        Token tk;
+        const auto kind = r.get<std::uint8_t>();
+        const auto op = r.get<std::uint8_t>();
+        if (kind > static_cast<std::uint8_t>(Kind::OpTok) || op > static_cast<std::uint8_t>(Op::FnProd)) {
+            throw std::runtime_error("Snapshot is corrupt");
+        }
+        tk.kind = static_cast<Kind>(kind);
+        tk.op = static_cast<Op>(op);
+        tk.pos = static_cast<std::size_t>(r.get<std::uint64_t>());
+        tk.lex = r.str(r.get<std::uint32_t>());
+        expr.tokens.push_back(std::move(tk));
+    }
+    const auto literalCount = r.get<std::uint32_t>();
+    r.checkCount(literalCount, 2 * static_cast<std::size_t>(recordSize));
+    expr.literals.reserve(literalCount);
+    for (std::uint32_t k = 0; k < literalCount; ++k) {
+        expr.literals.push_back(readComplex(r));
+    }
+    indexLiterals(expr);
+    return expr;
+}
+
+inline std::uint32_t bigRecordSize() {
+    std::string probe;
+    ByteWriter w{probe};
+    writeBig(w, Big(0));
+    return static_cast<std::uint32_t>(probe.size());
+}
+
+}  // namespace snapshot_detail
+
+struct SnapshotCounts {
+    std::size_t variables = 0;
+    std::size_t expressions = 0;
+};
+
+// cache 非空时一并保存其中的预编译表达式。
+inline SnapshotCounts saveSnapshot(const std::string& path,
+                                   const std::unordered_map<std::string, Complex>& variables,
+                                   const ExprCache* cache = nullptr) {
+    using namespace snapshot_detail;
+
+    const std::uint32_t recordSize = bigRecordSize();
+    std::string out;
+    out.reserve(32 + variables.size() * (2 * recordSize + 16));
+
+    ByteWriter w{out};
+    out.append(kMagic, sizeof(kMagic));
+    w.put(kVersion);
+    w.put(kByteOrderMark);
+    w.put(recordSize);
+    w.put(std::uint32_t{0});
+    w.put(static_cast<std::uint64_t>(variables.size()));
+
+    for (const auto& [name, value] : variables) {
+        writeString(w, name);
+        writeComplex(w, value);
+    }
+
+    SnapshotCounts counts;
+    counts.variables = variables.size();
+    // 缓存可能被其他会话并发修改，条目数在遍历后回填。
+    const std::size_t exprCountAt = out.size();
+    w.put(std::uint64_t{0});
+    if (cache) {
+        cache->forEachOldestFirst([&](const std::string& key, const CompiledExpr& expr) {
+            writeString(w, key);
+            writeCompiled(w, expr);
+            ++counts.expressions;
+        });
+    }
+    const auto exprCount = static_cast<std::uint64_t>(counts.expressions);
+    std::memcpy(&out[exprCountAt], &exprCount, sizeof(exprCount));
+    w.put(fnv1a(out.data(), out.size()));
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        throw std::runtime_error("Cannot open snapshot for writing: " + path);
+    }
+    file.write(out.data(), static_cast<std::streamsize>(out.size()));
+    if (!file) {
+        throw std::runtime_error("Failed to write snapshot: " + path);
+    }
+    return counts;
+}
+
+// 将快照中的变量合并进 variables（同名变量被覆盖）；cache 非空时同时恢复预编译表达式。
+// 先校验散列并把整个文件解析到临时容器，全部成功后才修改 variables 与 cache。
+inline SnapshotCounts loadSnapshot(const std::string& path,
+                                   std::unordered_map<std::string, Complex>& variables,
+                                   ExprCache* cache = nullptr) {
+    using namespace snapshot_detail;
+
+    MappedFile file(path);
+    ByteReader r{file.data(), file.data() + file.size()};
+
+    r.need(sizeof(kMagic));
+    if (std::memcmp(r.cur, kMagic, sizeof(kMagic)) != 0) {
+        throw std::runtime_error("Not a snapshot file: " + path);
+    }
+    r.cur += sizeof(kMagic);
+    if (r.get<std::uint32_t>() != kVersion) {
+        throw std::runtime_error("Unsupported snapshot version");
+    }
+    if (r.get<std::uint32_t>() != kByteOrderMark) {
+        throw std::runtime_error("Snapshot byte order does not match this machine");
+    }
+    const std::uint32_t recordSize = bigRecordSize();
+    if (r.get<std::uint32_t>() != recordSize) {
+        throw std::runtime_error("Snapshot precision does not match this build");
+    }
+    r.get<std::uint32_t>();
+
+    std::uint64_t checksum = 0;
+    r.need(sizeof(checksum));
+    r.end -= sizeof(checksum);
+    std::memcpy(&checksum, r.end, sizeof(checksum));
+    if (checksum != fnv1a(file.data(), file.size() - sizeof(checksum))) {
+        throw std::runtime_error("Snapshot checksum mismatch");
+    }
+
+    const auto varCount = r.get<std::uint64_t>();
+    r.checkCount(varCount, 4 + 2 * static_cast<std::size_t>(recordSize));
+    std::unordered_map<std::string, Complex> loaded;
+    loaded.reserve(static_cast<std::size_t>(varCount));
+    for (std::uint64_t k = 0; k < varCount; ++k) {
+        std::string name = r.str(r.get<std::uint32_t>());
+        loaded.insert_or_assign(std::move(name), readComplex(r));
+    }
+
+    const auto exprCount = r.get<std::uint64_t>();
+    r.checkCount(exprCount, 4 + 4 + 4);
+    std::vector<std::pair<std::string, ExprCache::Entry>> entries;
+    entries.reserve(static_cast<std::size_t>(exprCount));
+    for (std::uint64_t k = 0; k < exprCount; ++k) {
+        std::string key = r.str(r.get<std::uint32_t>());
+        entries.emplace_back(std::move(key), std::make_shared<const CompiledExpr>(readCompiled(r, recordSize)));
+    }
+    if (r.remaining() != 0) {
+        throw std::runtime_error("Snapshot is corrupt");
+    }
+
+    for (auto& [name, value] : loaded) {
+        variables.insert_or_assign(name, std::move(value));
+    }
+    SnapshotCounts counts;
+    counts.variables = static_cast<std::size_t>(varCount);
+    if (cache) {
+        for (auto& [key, entry] : entries) {
+            cache->insert(std::move(key), std::move(entry));
+        }
+        counts.expressions = entries.size();
+    }
+    return counts;
+}
+
+}  // namespace complex_eval
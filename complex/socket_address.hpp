@@ -0,0 +1,65 @@
+#pragma once
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace complex_eval {
+
+// 服务器与压测客户端共用的地址格式：
+//   unix:/path/to/socket   Unix 域套接字
+//   HOST:PORT 或 PORT      IPv4 回环地址（HOST 缺省为 127.0.0.1）
+// 服务器没有身份验证也不加密，任何能连上的客户端都能占用求值线程和共享的表达式缓存，
+// 因此只接受回环地址，不对外网开放。
+struct SocketAddress {
+    sockaddr_storage storage{};
+    socklen_t length = 0;
+    std::string unixPath;
+
+    int family() const { return storage.ss_family; }
+    const sockaddr* get() const { return reinterpret_cast<const sockaddr*>(&storage); }
+};
+
+inline SocketAddress parseSocketAddress(const std::string& text) {
+    SocketAddress addr;
+
+    if (text.rfind("unix:", 0) == 0) {
+        addr.unixPath = text.substr(5);
+        auto* un = reinterpret_cast<sockaddr_un*>(&addr.storage);
+        if (addr.unixPath.empty() || addr.unixPath.size() >= sizeof(un->sun_path)) {
+            throw std::runtime_error("Invalid unix socket path: " + addr.unixPath);
+        }
+        un->sun_family = AF_UNIX;
+        std::memcpy(un->sun_path, addr.unixPath.c_str(), addr.unixPath.size() + 1);
+        addr.length = static_cast<socklen_t>(sizeof(sockaddr_un));
+        return addr;
+    }
+
+    const std::size_t colon = text.rfind(':');
+    const std::string host = colon == std::string::npos ? "127.0.0.1" : text.substr(0, colon);
+    const std::string port = colon == std::string::npos ? text : text.substr(colon + 1);
+
+    auto* in = reinterpret_cast<sockaddr_in*>(&addr.storage);
+    in->sin_family = AF_INET;
+    if (::inet_pton(AF_INET, host.c_str(), &in->sin_addr) != 1) {
+        throw std::runtime_error("Invalid IPv4 address: " + host);
+    }
+    if ((ntohl(in->sin_addr.s_addr) >> 24) != 127) {
+        throw std::runtime_error("Only loopback addresses are supported: " + host);
+    }
+    const int portNumber = std::stoi(port);
+    if (portNumber <= 0 || portNumber > 65535) {
+        throw std::runtime_error("Invalid port: " + port);
+    }
+    in->sin_port = htons(static_cast<std::uint16_t>(portNumber));
+    addr.length = static_cast<socklen_t>(sizeof(sockaddr_in));
+    return addr;
+}
+
+}  // namespace complex_eval
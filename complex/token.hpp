@@ -6,7 +6,39 @@
 
 namespace complex_eval {
 
-enum class Op { Assign, Add, Sub, Mul, Div, LParen, RParen, FnCon, FnMod };
+enum class Op {
+    Assign, Add, Sub, Mul, Div, LParen, RParen, Comma,
+    FnCon, FnMod, FnExp, FnLog, FnSqrt, FnArg, FnPow, FnSum, FnProd
+};
+
+inline bool isFunction(Op op) {
+    switch (op) {
+        case Op::FnCon:
+        case Op::FnMod:
+        case Op::FnExp:
+        case Op::FnLog:
+        case Op::FnSqrt:
+        case Op::FnArg:
+        case Op::FnPow:
+        case Op::FnSum:
+        case Op::FnProd: return true;
+        default:         return false;
+    }
+}
+
+// sum/prod 的循环体要对每个下标重新求值，由求值器单独展开，不进入运算符栈。
+inline bool isReduction(Op op) {
+    return op == Op::FnSum || op == Op::FnProd;
+}
+
+inline int arity(Op op) {
+    switch (op) {
+        case Op::FnPow:  return 2;
+        case Op::FnSum:
+        case Op::FnProd: return 4;
+        default:         return 1;
+    }
+}
 
 struct BindingPower {
     int left;
@@ -23,7 +55,12 @@ constexpr BindingPower binding(Op op) {
         case Op::LParen:return {100, -1};
         case Op::RParen:return {-1, -1};
         case Op::FnCon:
-        case Op::FnMod: return {20, 19};
+        case Op::FnMod:
+        case Op::FnExp:
+        case Op::FnLog:
+        case Op::FnSqrt:
+        case Op::FnArg:
+        case Op::FnPow: return {20, 19};
         default:        return {-1, -1};
     }
 }
@@ -58,6 +95,7 @@ inline Op toOpChar(char c) {
         case '=': return Op::Assign;
         case '(': return Op::LParen;
         case ')': return Op::RParen;
+        case ',': return Op::Comma;
         default: throw std::runtime_error(std::string("unknown op char: ") + c);
     }
 }
@@ -0,0 +1,305 @@
+#pragma once
+
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+#include <boost/multiprecision/cpp_dec_float.hpp>
+
+#include "big_complex.hpp"
+
+namespace complex_eval {
+
+// 实数内核按数值类型 Real 模板化：π、ln2 等常数放在函数内静态变量中，
+// 每种精度在首次使用时计算一次，此后所有调用直接复用。
+namespace transcendental_detail {
+
+// 级数截断阈值。cpp_dec_float 内部比 digits10 多保留若干 limb，
+// 阈值取得比 epsilon 更严，以抵消后续平方、倍角带来的误差放大。
+template <class Real>
+const Real& tolerance() {
+    static const Real v = std::numeric_limits<Real>::epsilon() * Real("1e-12");
+    return v;
+}
+
+// |x| 较小时求 Σ (±1)^k x^(2k+1) / (2k+1)：alternate 为 true 得 atan，否则得 atanh。
+template <class Real>
+Real oddSeries(const Real& x, bool alternate) {
+    using boost::multiprecision::abs;
+    const Real x2 = x * x;
+    Real power = x;
+    Real sum = x;
+    for (unsigned k = 3;; k += 2) {
+        power *= x2;
+        if (alternate) power = -power;
+        Real term = power / k;
+        if (abs(term) <= tolerance<Real>() * abs(sum)) break;
+        sum += term;
+    }
+    return sum;
+}
+
+template <class Real>
+const Real& pi() {
+    // Machin: π = 16·atan(1/5) − 4·atan(1/239)
+    static const Real v = 16 * oddSeries(Real(1) / 5, true) - 4 * oddSeries(Real(1) / 239, true);
+    return v;
+}
+
+template <class Real>
+const Real& halfPi() {
+    static const Real v = pi<Real>() / 2;
+    return v;
+}
+
+// sin/cos 缩小参数用的加宽类型：位数为 Real 的 3 倍，|x| < 10^(2·digits10) 时
+// q·π/2 抵消掉的高位不超过 2·digits10，余数仍保留完整的 digits10 位。
+template <class Real>
+struct ReductionReal;
+
+template <unsigned Digits10, class Exponent, class Allocator,
+          boost::multiprecision::expression_template_option ET>
+struct ReductionReal<boost::multiprecision::number<
+    boost::multiprecision::backends::cpp_dec_float<Digits10, Exponent, Allocator>, ET>> {
+    using type = boost::multiprecision::number<
+        boost::multiprecision::backends::cpp_dec_float<3 * Digits10, Exponent, Allocator>, ET>;
+};
+
+template <class Real>
+const Real& maxReducible() {
+    static const Real v("1e" + std::to_string(2 * std::numeric_limits<Real>::digits10));
+    return v;
+}
+
+// |x| 小于该值时抵消的位数不超过 Real 保护位（max_digits10 − digits10）的四分之一，直接在原精度下缩小。
+template <class Real>
+const Real& maxDirectReducible() {
+    using limits = std::numeric_limits<Real>;
+    static const Real v("1e" + std::to_string((limits::max_digits10 - limits::digits10) / 4));
+    return v;
+}
+
+template <class Real>
+const Real& ln2() {
+    // ln2 = 18·atanh(1/26) − 2·atanh(1/4801) + 8·atanh(1/8749)
+    static const Real v = 18 * oddSeries(Real(1) / 26, false)
+                        - 2 * oddSeries(Real(1) / 4801, false)
+                        + 8 * oddSeries(Real(1) / 8749, false);
+    return v;
+}
+
+// 缩小参数时额外除以 2^n 的次数，随精度增长，使 Taylor 项数约为 sqrt(位数)。
+template <class Real>
+int halvings() {
+    static const int v = static_cast<int>(std::sqrt(static_cast<double>(std::numeric_limits<Real>::digits10)));
+    return v;
+}
+
+template <class Real>
+Real expReal(const Real& x) {
+    using boost::multiprecision::abs;
+    using boost::multiprecision::ldexp;
+    using boost::multiprecision::round;
+
+    if (x == 0) return Real(1);
+
+    // x = k·ln2 + r，|r| <= ln2/2；再把 r 缩小 2^s 倍，求和后平方 s 次。
+    const Real k = round(x / ln2<Real>());
+    if (abs(k) > std::numeric_limits<int>::max() / 2) {
+        if (k < 0) return Real(0);  // 下溢
+        throw std::runtime_error("exp argument out of range");
+    }
+    const int s = halvings<Real>();
+    const Real r = ldexp(Real(x - k * ln2<Real>()), -s);
+
+    Real term = 1;
+    Real sum = 1;
+    for (unsigned n = 1;; ++n) {
+        term *= r;
+        term /= n;
+        if (abs(term) <= tolerance<Real>() * sum) break;
+        sum += term;
+    }
+    for (int i = 0; i < s; ++i) sum *= sum;
+    return ldexp(sum, k.template convert_to<int>());
+}
+
+template <class Real>
+Real logReal(const Real& x) {
+    using boost::multiprecision::frexp;
+
+    if (x <= 0) {
+        throw std::runtime_error("Logarithm of non-positive real");
+    }
+    // x = m·2^e，把 m 调整到 [1/√2, √2)，ln m = 2·atanh((m−1)/(m+1))。
+    static const Real invSqrt2 = boost::multiprecision::sqrt(Real(1) / 2);
+    int e = 0;
+    Real m = frexp(x, &e);
+    if (m < invSqrt2) {
+        m *= 2;
+        --e;
+    }
+    return 2 * oddSeries(Real((m - 1) / (m + 1)), false) + e * ln2<Real>();
+}
+
+// x = q·π/2 + r，|r| <= π/4，返回 r 并把 q mod 4 写入 quadrant。
+// |x| 较大时在加宽精度下计算，避免 q·π/2 与 x 相减抵消掉 r 的全部有效位。
+template <class Real>
+Real reduceHalfPi(const Real& x, int& quadrant) {
+    using boost::multiprecision::abs;
+    using boost::multiprecision::fmod;
+    using boost::multiprecision::round;
+    using Wide = typename ReductionReal<Real>::type;
+
+    quadrant = 0;
+    if (abs(x) <= halfPi<Real>() / 2) return x;
+    if (abs(x) < maxDirectReducible<Real>()) {
+        const Real q = round(x / halfPi<Real>());
+        quadrant = fmod(q, Real(4)).template convert_to<int>();
+        if (quadrant < 0) quadrant += 4;
+        return x - q * halfPi<Real>();
+    }
+    if (abs(x) >= maxReducible<Real>()) {
+        throw std::runtime_error("sin/cos argument out of range");
+    }
+    const Wide wx(x);
+    const Wide q = round(wx / halfPi<Wide>());
+    quadrant = fmod(q, Wide(4)).template convert_to<int>();
+    if (quadrant < 0) quadrant += 4;
+    return Real(wx - q * halfPi<Wide>());
+}
+
+template <class Real>
+void sinCos(const Real& x, Real& sinOut, Real& cosOut) {
+    using boost::multiprecision::abs;
+
+    int quadrant = 0;
+    const Real r = reduceHalfPi(x, quadrant);
+    const Real r2 = r * r;
+
+    Real sn = r;
+    Real term = r;
+    for (unsigned n = 3;; n += 2) {
+        term *= r2;
+        term /= (n - 1) * n;
+        term = -term;
+        if (abs(term) <= tolerance<Real>() * abs(sn)) break;
+        sn += term;
+    }
+
+    Real cs = 1;
+    term = 1;
+    for (unsigned n = 2;; n += 2) {
+        term *= r2;
+        term /= (n - 1) * n;
+        term = -term;
+        if (abs(term) <= tolerance<Real>() * cs) break;
+        cs += term;
+    }
+
+    switch (quadrant) {
+        case 0: sinOut = sn;  cosOut = cs;  break;
+        case 1: sinOut = cs;  cosOut = -sn; break;
+        case 2: sinOut = -sn; cosOut = -cs; break;
+        default: sinOut = -cs; cosOut = sn; break;
+    }
+}
+
+template <class Real>
+Real atanReal(const Real& x) {
+    using boost::multiprecision::ldexp;
+    using boost::multiprecision::sqrt;
+
+    if (x == 0) return Real(0);
+    if (x < 0) return -atanReal(Real(-x));
+    if (x > 1) return halfPi<Real>() - atanReal(Real(1 / x));
+
+    // atan(x) = 2·atan(x / (1 + sqrt(1 + x²)))，折半三次后 |t| < tan(π/32)。
+    Real t = x;
+    for (int i = 0; i < 3; ++i) {
+        t = t / (1 + sqrt(1 + t * t));
+    }
+    return ldexp(oddSeries(t, true), 3);
+}
+
+template <class Real>
+Real atan2Real(const Real& y, const Real& x) {
+    if (x > 0) return atanReal(Real(y / x));
+    if (x < 0) {
+        const Real base = atanReal(Real(y / x));
+        if (y >= 0) return base + pi<Real>();
+        return base - pi<Real>();
+    }
+    if (y > 0) return halfPi<Real>();
+    if (y < 0) return -halfPi<Real>();
+    return Real(0);
+}
+
+}  // namespace transcendental_detail
+
+inline Complex expComplex(const Complex& z) {
+    using namespace transcendental_detail;
+    const Big scale = expReal(z.realPart());
+    if (z.imagPart() == 0) {
+        return Complex(scale, Big(0));
+    }
+    Big s, c;
+    sinCos(z.imagPart(), s, c);
+    return Complex(scale * c, scale * s);
+}
+
+// 主值分支：虚部落在 (−π, π]。
+inline Complex logComplex(const Complex& z) {
+    using namespace transcendental_detail;
+    const Big& x = z.realPart();
+    const Big& y = z.imagPart();
+    if (x == 0 && y == 0) {
+        throw std::runtime_error("Logarithm of zero");
+    }
+    const Big re = (y == 0) ? logReal(Big(boost::multiprecision::abs(x)))
+                            : Big(logReal(Big(x * x + y * y)) / 2);
+    return Complex(re, atan2Real(y, x));
+}
+
+inline Complex argComplex(const Complex& z) {
+    return Complex(transcendental_detail::atan2Real(z.imagPart(), z.realPart()), Big(0));
+}
+
+// 主值平方根，实部非负；按实部符号选择公式以避免相消。
+inline Complex sqrtComplex(const Complex& z) {
+    using boost::multiprecision::abs;
+    using boost::multiprecision::sqrt;
+
+    const Big& x = z.realPart();
+    const Big& y = z.imagPart();
+    if (x == 0 && y == 0) {
+        return Complex(Big(0), Big(0));
+    }
+    const Big r = z.magnitude();
+    if (x >= 0) {
+        const Big t = sqrt((r + x) / 2);
+        return Complex(t, y / (2 * t));
+    }
+    const Big t = sqrt((r - x) / 2);
+    return Complex(abs(y) / (2 * t), y < 0 ? Big(-t) : t);
+}
+
+// 整数次幂，平方求幂；负指数取倒数。
+inline Complex powComplex(const Complex& base, long long exponent) {
+    Complex result(Big(1), Big(0));
+    Complex square = base;
+    unsigned long long n = exponent < 0 ? 0ULL - static_cast<unsigned long long>(exponent)
+                                        : static_cast<unsigned long long>(exponent);
+    while (n != 0) {
+        if (n & 1ULL) result = result * square;
+        n >>= 1;
+        if (n != 0) square = square * square;
+    }
+    if (exponent < 0) {
+        return Complex(Big(1), Big(0)) / result;
+    }
+    return result;
+}
+
+}  // namespace complex_eval
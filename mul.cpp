@@ -2,6 +2,8 @@
 #include <string>   // 用于 std::stod 和 std::string
 #include <stdexcept> // 用于捕获 std::stod 可能抛出的异常 (std::invalid_argument, std::out_of_range)
 #include <vector>
+#include <algorithm> // 用于 std::reverse
+#include <cmath>     // 用于 Newton 迭代初值 (std::sqrt, std::pow, std::llround)
 
 
 // 高精度浮点数乘法
@@ -16,11 +18,29 @@ std::string bigbigmul (const std::string &num1, const std::string &num2);// 大
 HighPrecisionFloat parseString(const std::string& str);// 解析字符串为高精度浮点数
 void HighPrecisionMultiply(const HighPrecisionFloat& num1, const HighPrecisionFloat& num2,bool useScientific);// 高精度乘法函数声明
 
+// 以下为除法、倒数、开方：全部基于 bigbigmul 的 Newton 迭代，精度逐步翻倍，
+// 总代价约为目标精度下一次完整乘法的常数倍。数字串均为不带符号的十进制整数。
+std::string stripLeadingZeros(const std::string& num);// 去掉前导零（全零返回 "0"）
+int bigCompare(const std::string& num1, const std::string& num2);// 比较大小，返回 -1 / 0 / 1
+std::string bigAdd(const std::string& num1, const std::string& num2);// 大数加法
+std::string bigSub(const std::string& num1, const std::string& num2);// 大数减法，要求 num1 >= num2
+std::string bigShiftRight(const std::string& num, int k);// 除以 10^k 并向下取整
+std::string bigHalf(const std::string& num);// 除以 2 并向下取整
+std::vector<int> newtonSchedule(int k);// Newton 迭代每一步的精度（位数），从小到大
+std::string bigReciprocal(const std::string& den, int k);// 约等于 10^(m+k) / den，m 为 den 的位数
+std::string bigInvSqrt(const std::string& digits, int k);// 约等于 10^k / sqrt(0.digits)，digits 位数为偶数
+std::string bigDivMod(const std::string& num, const std::string& den, std::string& rem);// 整数除法：商与余数
+std::string bigSqrtFloor(const std::string& num, std::string& rem);// 整数平方根（向下取整）与余数 num - root^2
+void HighPrecisionDivide(const HighPrecisionFloat& num1, const HighPrecisionFloat& num2, int precision, bool useScientific);// 高精度除法
+void HighPrecisionSqrt(const HighPrecisionFloat& num, int precision, bool useScientific);// 高精度平方根
+
 
 int main(int argc, char* argv[]) {
     // 检查命令行参数数量
     bool useScientific = false;
     bool useHighPrecision = false;
+    std::string op = "mul"; // 运算类型：mul / div / recip / sqrt
+    int precision = 50;     // div / recip / sqrt 的有效数字位数
     std::vector<std::string> numbers;
     
     for (int i = 1; i < argc; i++) {
@@ -30,17 +50,66 @@ int main(int argc, char* argv[]) {
             useScientific = true;
         } else if (arg == "-h") {
             useHighPrecision = true;
+        } else if (arg == "--op" && i + 1 < argc) {
+            op = argv[++i];
+        } else if (arg == "-p" && i + 1 < argc) {
+            try {
+                precision = std::stoi(argv[++i]);
+            } catch (const std::exception&) {
+                precision = 0;
+            }
+            if (precision < 1) {
+                std::cerr << "错误: -p 需要一个正整数。" << std::endl;
+                return 1;
+            }
         } else if (arg == "--help") {
-            std::cout << "用法: " << argv[0] << " [选项] <数字1> <数字2>" << std::endl;
+            std::cout << "用法: " << argv[0] << " [选项] <数字1> [数字2]" << std::endl;
             std::cout << "选项:" << std::endl;
             std::cout << "  -s               高精度计算下使用科学计数法输出" << std::endl;
             std::cout << "  -h               使用高精度计算" << std::endl;
+            std::cout << "  --op OP          运算类型: mul（默认）、div（数字1 / 数字2）、recip（1 / 数字1）、sqrt（开平方）" << std::endl;
+            std::cout << "  -p N             div / recip / sqrt 结果的有效数字位数（默认 50，四舍六入五成双）" << std::endl;
             std::cout << "  --help           显示此帮助信息" << std::endl;
             return 0;
         } else {
             numbers.push_back(arg);
         }
     }
+
+    // 除法、倒数、开方总是使用高精度计算
+    if (op == "div" || op == "recip" || op == "sqrt") {
+        const size_t expected = (op == "div") ? 2 : 1;
+        if (numbers.size() != expected) {
+            std::cerr << "错误: " << op << " 需要提供 " << expected << " 个数字。" << std::endl;
+            std::cerr << "使用 --help 查看用法说明。" << std::endl;
+            return 1;
+        }
+        try {
+            if (op == "div") {
+                HighPrecisionDivide(parseString(numbers[0]), parseString(numbers[1]), precision, useScientific);
+            } else if (op == "recip") {
+                HighPrecisionDivide(parseString("1"), parseString(numbers[0]), precision, useScientific);
+            } else {
+                HighPrecisionSqrt(parseString(numbers[0]), precision, useScientific);
+            }
+        } catch (const std::invalid_argument&) {
+            std::cerr << "输入不能被解析为一个数字！" << std::endl;
+            return 1;
+        } catch (const std::out_of_range&) {
+            std::cerr << "输入的数字超出范围！" << std::endl;
+            return 1;
+        } catch (const std::domain_error& e) {
+            std::cerr << "错误: " << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+    if (op != "mul") {
+        std::cerr << "错误: 未知运算 " << op << "。" << std::endl;
+        std::cerr << "使用 --help 查看用法说明。" << std::endl;
+        return 1;
+    }
+
     // 确保有且仅有两个数字参数
     if (numbers.size() != 2) {
         std::cerr << "错误: 需要提供两个数字进行乘法运算。" << std::endl;
@@ -111,6 +180,7 @@ std::string bigbigmul (const std::string &num1, const std::string &num2) {
 
 HighPrecisionFloat parseString(const std::string& str){
     HighPrecisionFloat hpf;
+    hpf.negative = false;
     size_t pos = 0;
 
     // 处理符号
@@ -221,4 +291,292 @@ void HighPrecisionMultiply(const HighPrecisionFloat& num1, const HighPrecisionFl
         }
         std::cout << "Result: " << (result_negative ? "-" : "") << result << std::endl;
     }
-}
\ No newline at end of file
+}
+
+std::string stripLeadingZeros(const std::string& num) {
+    size_t pos = num.find_first_not_of('0');
+    if (pos == std::string::npos) return "0";
+    return num.substr(pos);
+}
+
+int bigCompare(const std::string& num1, const std::string& num2) {
+    // 两个数都不带前导零，先比位数再按字典序比较
+    if (num1.size() != num2.size()) return num1.size() < num2.size() ? -1 : 1;
+    int cmp = num1.compare(num2);
+    return cmp < 0 ? -1 : (cmp > 0 ? 1 : 0);
+}
+
+std::string bigAdd(const std::string& num1, const std::string& num2) {
+    std::string res;
+    int i = num1.size() - 1;
+    int j = num2.size() - 1;
+    int carry = 0;
+    // 从低位向高位逐位相加
+    while (i >= 0 || j >= 0 || carry) {
+        int sum = carry;
+        if (i >= 0) sum += num1[i--] - '0';
+        if (j >= 0) sum += num2[j--] - '0';
+        res += (sum % 10 + '0');
+        carry = sum / 10;
+    }
+    std::reverse(res.begin(), res.end());
+    return stripLeadingZeros(res);
+}
+
+std::string bigSub(const std::string& num1, const std::string& num2) {
+    std::string res = num1;
+    int j = num2.size() - 1;
+    int borrow = 0;
+    // 从低位向高位逐位相减
+    for (int i = res.size() - 1; i >= 0; i--) {
+        int diff = (res[i] - '0') - borrow - (j >= 0 ? num2[j--] - '0' : 0);
+        borrow = diff < 0;
+        res[i] = (diff + (borrow ? 10 : 0)) + '0';
+        if (j < 0 && !borrow) break;
+    }
+    return stripLeadingZeros(res);
+}
+
+std::string bigShiftRight(const std::string& num, int k) {
+    if (k <= 0) return num;
+    if (k >= (int)num.size()) return "0";
+    return stripLeadingZeros(num.substr(0, num.size() - k));
+}
+
+std::string bigHalf(const std::string& num) {
+    std::string res;
+    int rem = 0;
+    // 从高位向低位逐位除以 2
+    for (char c : num) {
+        int cur = rem * 10 + (c - '0');
+        res += (cur / 2 + '0');
+        rem = cur % 2;
+    }
+    return stripLeadingZeros(res);
+}
+
+std::vector<int> newtonSchedule(int k) {
+    // 从目标位数反推：每一步约为后一步的一半再加两位保护位，
+    // 直到双精度浮点数算出的初值就足够（14 位）为止。
+    // 这样每一步的位数不超过前一步的两倍减二，最后一步恰好落在 k 上。
+    std::vector<int> steps;
+    int h = k;
+    while (h > 14) {
+        steps.push_back(h);
+        h = h / 2 + 2;
+    }
+    steps.push_back(h);
+    std::reverse(steps.begin(), steps.end());
+    return steps;
+}
+
+std::string bigReciprocal(const std::string& den, int k) {
+    // 记 b = den / 10^m ∈ [0.1, 1)，x ≈ 1/b ∈ (1, 10]，以 X = x * 10^h 的整数形式保存。
+    // Newton 迭代 x' = x + x(1 - b x)，每步只取 b 的前 h' 位参与运算。
+    std::vector<int> steps = newtonSchedule(k);
+    int h = steps[0];
+    double b = std::stod("0." + den.substr(0, 17));
+    std::string x = std::to_string(std::llround(std::pow(10.0, h) / b));
+
+    for (size_t s = 1; s < steps.size(); s++) {
+        int next = steps[s];
+        std::string bj = (int)den.size() >= next ? den.substr(0, next)
+                                                 : den + std::string(next - den.size(), '0');
+        // T = 10^(h'+h) - b_j * X，x(1 - b x) 换算到 10^-h' 单位为 X * T / 10^(2h)
+        std::string product = stripLeadingZeros(bigbigmul(bj, x));
+        std::string one = "1" + std::string(next + h, '0');
+        std::string scaled = x + std::string(next - h, '0');
+        if (bigCompare(one, product) >= 0) {
+            std::string t = bigSub(one, product);
+            x = bigAdd(scaled, bigShiftRight(stripLeadingZeros(bigbigmul(x, t)), 2 * h));
+        } else {
+            std::string t = bigSub(product, one);
+            x = bigSub(scaled, bigShiftRight(stripLeadingZeros(bigbigmul(x, t)), 2 * h));
+        }
+        h = next;
+    }
+    return x;
+}
+
+std::string bigInvSqrt(const std::string& digits, int k) {
+    // 记 a = 0.digits ∈ [0.01, 1)，y ≈ 1/sqrt(a) ∈ (1, 10]，以 Y = y * 10^h 的整数形式保存。
+    // Newton 迭代 y' = y + y(1 - a y^2) / 2，每步只取 a 的前 h' 位参与运算。
+    std::vector<int> steps = newtonSchedule(k);
+    int h = steps[0];
+    double a = std::stod("0." + digits.substr(0, 17));
+    std::string y = std::to_string(std::llround(std::pow(10.0, h) / std::sqrt(a)));
+
+    for (size_t s = 1; s < steps.size(); s++) {
+        int next = steps[s];
+        std::string aj = (int)digits.size() >= next ? digits.substr(0, next)
+                                                    : digits + std::string(next - digits.size(), '0');
+        aj = stripLeadingZeros(aj);
+        // T = 10^(h'+2h) - a_j * Y^2，y(1 - a y^2)/2 换算到 10^-h' 单位为 Y * T / (2 * 10^(3h))
+        std::string square = stripLeadingZeros(bigbigmul(y, y));
+        std::string product = stripLeadingZeros(bigbigmul(aj, square));
+        std::string one = "1" + std::string(next + 2 * h, '0');
+        std::string scaled = y + std::string(next - h, '0');
+        if (bigCompare(one, product) >= 0) {
+            std::string t = bigSub(one, product);
+            y = bigAdd(scaled, bigHalf(bigShiftRight(stripLeadingZeros(bigbigmul(y, t)), 3 * h)));
+        } else {
+            std::string t = bigSub(product, one);
+            y = bigSub(scaled, bigHalf(bigShiftRight(stripLeadingZeros(bigbigmul(y, t)), 3 * h)));
+        }
+        h = next;
+    }
+    return y;
+}
+
+std::string bigDivMod(const std::string& num, const std::string& den, std::string& rem) {
+    if (bigCompare(num, den) < 0) {
+        rem = num;
+        return "0";
+    }
+    int n = num.size();
+    int m = den.size();
+    int k = n - m + 2; // 商最多 n-m+1 位，再多算一位保护位
+    // q ≈ num * (10^(m+k) / den) / 10^(m+k)，误差只有个位上的几个单位
+    std::string x = bigReciprocal(den, k);
+    std::string q = bigShiftRight(stripLeadingZeros(bigbigmul(num, x)), m + k);
+    std::string product = stripLeadingZeros(bigbigmul(q, den));
+    // 用余数精确修正，保证 0 <= rem < den
+    while (bigCompare(product, num) > 0) {
+        q = bigSub(q, "1");
+        product = bigSub(product, den);
+    }
+    rem = bigSub(num, product);
+    while (bigCompare(rem, den) >= 0) {
+        q = bigAdd(q, "1");
+        rem = bigSub(rem, den);
+    }
+    return q;
+}
+
+std::string bigSqrtFloor(const std::string& num, std::string& rem) {
+    if (num == "0") {
+        rem = "0";
+        return "0";
+    }
+    // 补成偶数位：a = 0.digits，sqrt(num) = num * (1/sqrt(a)) / 10^(len/2)
+    std::string digits = (num.size() % 2 == 1) ? "0" + num : num;
+    int half = digits.size() / 2;
+    int k = half + 2;
+    std::string y = bigInvSqrt(digits, k);
+    std::string root = bigShiftRight(stripLeadingZeros(bigbigmul(num, y)), half + k);
+    // 精确修正，保证 root^2 <= num < (root+1)^2；相邻平方差为 2root+1，只需加减
+    std::string square = stripLeadingZeros(bigbigmul(root, root));
+    while (bigCompare(square, num) > 0) {
+        root = bigSub(root, "1");
+        square = bigSub(square, bigAdd(bigAdd(root, root), "1"));
+    }
+    while (true) {
+        std::string next = bigAdd(square, bigAdd(bigAdd(root, root), "1"));
+        if (bigCompare(next, num) > 0) break;
+        root = bigAdd(root, "1");
+        square = next;
+    }
+    rem = bigSub(num, square);
+    return root;
+}
+
+// 将解析结果转换为 digits * 10^exp10 的形式，digits 不带前导零
+static void toScaledInteger(const HighPrecisionFloat& num, std::string& digits, long& exp10) {
+    std::string all = num.integerPart + num.fractionalPart;
+    if (all.empty() || all.find_first_not_of("0123456789") != std::string::npos) {
+        throw std::invalid_argument("not a number");
+    }
+    digits = stripLeadingZeros(all);
+    exp10 = (long)num.exponent - (long)num.fractionalPart.size();
+}
+
+// 按“四舍六入五成双”进位：cmp 为被舍去部分与半个末位单位的比较结果
+static void roundHalfEven(std::string& digits, long& exp10, int cmp) {
+    if (cmp > 0 || (cmp == 0 && (digits.back() - '0') % 2 == 1)) {
+        size_t width = digits.size();
+        digits = bigAdd(digits, "1");
+        if (digits.size() > width) { // 进位成 10...0，多出一位
+            digits.pop_back();
+            exp10++;
+        }
+    }
+}
+
+// 输出 digits * 10^exp10，digits 即全部有效数字
+static void printRounded(const std::string& digits, long exp10, bool negative, bool useScientific) {
+    std::string result = digits;
+    long width = digits.size();
+    if (useScientific) {
+        if (width > 1) result.insert(1, ".");
+        std::cout << "Result: " << (negative ? "-" : "") << result << "e" << exp10 + width - 1 << std::endl;
+        return;
+    }
+    long point = width + exp10; // 小数点前的位数
+    if (point <= 0) {
+        result = "0." + std::string(-point, '0') + result;
+    } else if (point >= width) {
+        result.append(point - width, '0');
+    } else {
+        result.insert(point, ".");
+    }
+    std::cout << "Result: " << (negative ? "-" : "") << result << std::endl;
+}
+
+void HighPrecisionDivide(const HighPrecisionFloat& num1, const HighPrecisionFloat& num2, int precision, bool useScientific) {
+    std::string a, b;
+    long expA, expB;
+    toScaledInteger(num1, a, expA);
+    toScaledInteger(num2, b, expB);
+    if (b == "0") throw std::domain_error("除数不能为零。");
+    if (a == "0") {
+        std::cout << "Result: 0" << std::endl;
+        return;
+    }
+
+    // 选取 s 使商 floor(a * 10^s / b) 恰好有 precision 位：
+    // 若 a 的有效数字（左对齐后）不小于 b 的，商的首位在小数点前，需要少放大一位
+    size_t width = std::max(a.size(), b.size());
+    bool aligned = (a + std::string(width - a.size(), '0')) >= (b + std::string(width - b.size(), '0'));
+    long s = (long)precision - (long)a.size() + (long)b.size() - (aligned ? 1 : 0);
+    std::string num = s > 0 ? a + std::string(s, '0') : a;
+    std::string den = s < 0 ? b + std::string(-s, '0') : b;
+
+    std::string rem;
+    std::string q = bigDivMod(num, den, rem);
+    long exp10 = expA - expB - s;
+    roundHalfEven(q, exp10, bigCompare(bigAdd(rem, rem), den));
+    printRounded(q, exp10, num1.negative ^ num2.negative, useScientific);
+}
+
+void HighPrecisionSqrt(const HighPrecisionFloat& num, int precision, bool useScientific) {
+    std::string a;
+    long expA;
+    toScaledInteger(num, a, expA);
+    if (a == "0") {
+        std::cout << "Result: 0" << std::endl;
+        return;
+    }
+    if (num.negative) throw std::domain_error("不能对负数开平方。");
+
+    // 指数调成偶数，sqrt(a * 10^e) = sqrt(a) * 10^(e/2)
+    if (expA % 2 != 0) {
+        a += "0";
+        expA--;
+    }
+    // floor(sqrt(a * 10^(2t))) 的位数为 ceil(len/2) + t，取 t 使其恰好为 precision 位；
+    // t < 0 时先截掉 a 的低 drop 位（对整数平方根结果没有影响）
+    long t = (long)precision - (long)(a.size() + 1) / 2;
+    long drop = t < 0 ? -2 * t : 0;
+    std::string n = t >= 0 ? a + std::string(2 * t, '0') : bigShiftRight(a, drop);
+    std::string rem;
+    std::string root = bigSqrtFloor(n, rem);
+    // 是否进位：精确值 x = n + low / 10^drop，比较 4x 与 (2root+1)^2，
+    // 两边减去 4root^2 后即比较 4(rem * 10^drop + low) 与 (4root+1) * 10^drop
+    std::string rest = stripLeadingZeros(rem + a.substr(a.size() - drop));
+    std::string fourRoot = bigAdd(bigAdd(root, root), bigAdd(root, root));
+    int cmp = bigCompare(bigAdd(bigAdd(rest, rest), bigAdd(rest, rest)),
+                         stripLeadingZeros(bigAdd(fourRoot, "1") + std::string(drop, '0')));
+    long exp10 = expA / 2 - t;
+    roundHalfEven(root, exp10, cmp);
+    printRounded(root, exp10, false, useScientific);
+}